@@ -0,0 +1,186 @@
+#pragma once
+
+#include <intrusive/intrusive.h>
+#include <shared/shared.h>
+
+#include <algorithm>
+#include <cstddef>  // size_t, std::max_align_t
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump-allocated memory for the objects of one request, released in bulk. Every allocation
+// holds a reference to the region, and so does the `ArenaScope` that made it; freeing an
+// object only drops a reference, and the chunks go back to the heap when the last one drops.
+// Memory of freed objects is not reused before that.
+// Not thread-safe, like the counters of `SharedPtr` and `SimpleRefCounted`.
+class ArenaRegion {
+public:
+    explicit ArenaRegion(size_t chunk_size) : chunk_size_(chunk_size) {
+    }
+
+    ArenaRegion(const ArenaRegion&) = delete;
+    ArenaRegion& operator=(const ArenaRegion&) = delete;
+
+    ~ArenaRegion() {
+        for (void* chunk : chunks_) {
+            ::operator delete(chunk);
+        }
+    };
+
+    // Aligned to `std::max_align_t`, adds a reference
+    void* Allocate(size_t size) {
+        size = AlignUp(size);
+        if (size > static_cast<size_t>(end_ - next_)) {
+            size_t chunk_size = std::max(chunk_size_, size);
+            chunks_.reserve(chunks_.size() + 1);
+            next_ = static_cast<char*>(::operator new(chunk_size));
+            end_ = next_ + chunk_size;
+            chunks_.push_back(next_);
+        }
+        ++refs_;
+        return std::exchange(next_, next_ + size);
+    };
+
+    void AddRef() noexcept {
+        ++refs_;
+    };
+    // Frees every chunk with the last reference
+    void Release() noexcept {
+        if (--refs_ == 0) {
+            delete this;
+        }
+    };
+
+    // Innermost `ArenaScope` of this thread
+    static ArenaRegion*& Current() noexcept {
+        thread_local ArenaRegion* current = nullptr;
+        return current;
+    };
+
+    static constexpr size_t AlignUp(size_t size) noexcept {
+        constexpr size_t kAlign = alignof(std::max_align_t);
+        return (size + kAlign - 1) / kAlign * kAlign;
+    }
+
+private:
+    size_t chunk_size_;
+    size_t refs_ = 0;
+    char* next_ = nullptr;
+    char* end_ = nullptr;
+    std::vector<void*> chunks_;
+};
+
+// Sends `MakeScopedShared` and `MakeScopedIntrusive` allocations made on this thread while
+// it is alive to a new region. Scopes nest, the innermost one is used. Objects may outlive
+// their scope: the region is released when the scope and all its objects are gone.
+class ArenaScope {
+public:
+    explicit ArenaScope(size_t chunk_size = 64 * 1024)
+        : region_(new ArenaRegion(chunk_size)), outer_(ArenaRegion::Current()) {
+        region_->AddRef();
+        ArenaRegion::Current() = region_;
+    }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    ~ArenaScope() {
+        ArenaRegion::Current() = outer_;
+        region_->Release();
+    };
+
+private:
+    ArenaRegion* region_;
+    ArenaRegion* outer_;
+};
+
+namespace arena {
+
+// Every block starts with the region it came from, `nullptr` for blocks from the heap
+inline constexpr size_t kPrefixSize = ArenaRegion::AlignUp(sizeof(ArenaRegion*));
+
+inline void* Allocate(size_t size) {
+    ArenaRegion* region = ArenaRegion::Current();
+    void* block = region != nullptr ? region->Allocate(kPrefixSize + size)
+                                    : ::operator new(kPrefixSize + size);
+    *static_cast<ArenaRegion**>(block) = region;
+    return static_cast<char*>(block) + kPrefixSize;
+}
+
+inline void Deallocate(void* ptr) noexcept {
+    void* block = static_cast<char*>(ptr) - kPrefixSize;
+    if (ArenaRegion* region = *static_cast<ArenaRegion**>(block)) {
+        region->Release();
+    } else {
+        ::operator delete(block);
+    }
+}
+
+}  // namespace arena
+
+// `MakeShared` block that comes from the current region; `SharedPtr` frees it with `delete`,
+// which ends up in the class-specific `operator delete`
+template <typename T>
+class ArenaControlBlock : public ControlBlockWithObject<T> {
+public:
+    using ControlBlockWithObject<T>::ControlBlockWithObject;
+
+    static void* operator new(size_t size) {
+        static_assert(alignof(ArenaControlBlock) <= alignof(std::max_align_t),
+                      "Over-aligned types are not supported");
+        return arena::Allocate(size);
+    }
+    static void operator delete(void* ptr) noexcept {
+        arena::Deallocate(ptr);
+    }
+};
+
+// Deleter of `RefCounted` objects made by `MakeScopedIntrusive`:
+// `SimpleRefCounted<Node, ArenaDelete>`. Trivially destructible objects are not destroyed
+// one by one, their memory is dropped with the region.
+struct ArenaDelete {
+    template <typename T>
+    static void Destroy(T* object) {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            object->~T();
+        }
+        arena::Deallocate(object);
+    }
+};
+
+namespace arena {
+
+template <typename T, typename Counter>
+std::true_type FreesToRegion(const RefCounted<T, Counter, ArenaDelete>*);
+template <typename T>
+std::false_type FreesToRegion(const void*);
+
+// Whether `T` derives from `RefCounted<T, Counter, ArenaDelete>`, so its last `DecRef`
+// gives the memory back to the region instead of `delete`-ing it
+template <typename T>
+inline constexpr bool kFreesToRegion = decltype(FreesToRegion<T>(static_cast<T*>(nullptr)))::value;
+
+}  // namespace arena
+
+// `MakeShared` that allocates the control block and the object in the current region
+template <typename T, typename... Args>
+SharedPtr<T> MakeScopedShared(Args&&... args) {
+    auto* block = new ArenaControlBlock<T>(std::forward<Args>(args)...);
+    return SharedPtr<T>(block, block->Get());
+};
+
+// `MakeIntrusive` that allocates the object in the current region
+template <typename T, typename... Args>
+IntrusivePtr<T> MakeScopedIntrusive(Args&&... args) {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned types are not supported");
+    static_assert(arena::kFreesToRegion<T>, "Derive from `SimpleRefCounted<T, ArenaDelete>`");
+    void* memory = arena::Allocate(sizeof(T));
+    try {
+        return IntrusivePtr<T>(::new (memory) T(std::forward<Args>(args)...));
+    } catch (...) {
+        arena::Deallocate(memory);
+        throw;
+    }
+};
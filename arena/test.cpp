@@ -0,0 +1,122 @@
+#include "arena.h"
+
+#include <catch.hpp>
+
+#include "allocations_checker.h"
+
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Request {
+    explicit Request(std::string path) : path(std::move(path)) {
+        ++alive;
+    }
+    ~Request() {
+        --alive;
+    }
+
+    static inline int alive = 0;
+
+    std::string path;
+    std::vector<SharedPtr<Request>> children;
+};
+
+struct Token : SimpleRefCounted<Token, ArenaDelete> {
+    explicit Token(int kind) : kind(kind) {
+    }
+
+    int kind;
+};
+
+struct Header : SimpleRefCounted<Header, ArenaDelete> {
+    std::string name;
+    IntrusivePtr<Token> token;
+};
+
+struct Plain : SimpleRefCounted<Plain> {};
+
+// `MakeScopedIntrusive` only makes objects that free themselves to the region
+static_assert(arena::kFreesToRegion<Token>);
+static_assert(!arena::kFreesToRegion<Plain>);
+static_assert(!arena::kFreesToRegion<Request>);
+
+TEST_CASE("ArenaScope") {
+    SECTION("Objects are made in the region") {
+        ArenaScope scope;
+        auto first = MakeScopedShared<int>(1);
+        EXPECT_ZERO_ALLOCATIONS(MakeScopedShared<int>(2));
+        EXPECT_ZERO_ALLOCATIONS(MakeScopedIntrusive<Token>(3));
+
+        auto second = MakeScopedShared<int>(2);
+        REQUIRE(*second == 2);
+        REQUIRE(reinterpret_cast<char*>(second.Get()) > reinterpret_cast<char*>(first.Get()));
+    }
+
+    SECTION("Destructors run, the memory goes with the region") {
+        {
+            ArenaScope scope;
+            auto root = MakeScopedShared<Request>("/");
+            for (int i = 0; i < 1000; ++i) {
+                root->children.push_back(MakeScopedShared<Request>("/child"));
+            }
+            REQUIRE(Request::alive == 1001);
+        }
+        REQUIRE(Request::alive == 0);
+    }
+
+    SECTION("Objects outlive the scope") {
+        SharedPtr<Request> kept;
+        IntrusivePtr<Header> header;
+        {
+            ArenaScope scope(256);
+            kept = MakeScopedShared<Request>("/kept");
+            for (int i = 0; i < 100; ++i) {
+                MakeScopedShared<Request>("/dropped");
+            }
+            header = MakeScopedIntrusive<Header>();
+            header->name = "Accept";
+            header->token = MakeScopedIntrusive<Token>(7);
+        }
+        REQUIRE(Request::alive == 1);
+        REQUIRE(kept->path == "/kept");
+        REQUIRE(header->token->kind == 7);
+
+        auto copy = kept;
+        kept.Reset();
+        REQUIRE(copy->path == "/kept");
+        header.Reset();
+        copy.Reset();
+        REQUIRE(Request::alive == 0);
+    }
+
+    SECTION("Nested scopes and the heap") {
+        SharedPtr<int> outer_object;
+        SharedPtr<int> inner_object;
+        {
+            ArenaScope outer;
+            {
+                ArenaScope inner;
+                inner_object = MakeScopedShared<int>(1);
+            }
+            outer_object = MakeScopedShared<int>(2);
+        }
+        auto heap_object = MakeScopedShared<int>(3);
+        auto heap_token = MakeScopedIntrusive<Token>(4);
+
+        REQUIRE(*inner_object + *outer_object + *heap_object + heap_token->kind == 10);
+    }
+
+    SECTION("Large objects") {
+        ArenaScope scope(64);
+        auto big = MakeScopedShared<std::vector<int>>(1000, 5);
+        struct Blob {
+            char bytes[4096];
+        };
+        auto blob = MakeScopedShared<Blob>();
+
+        REQUIRE(big->at(999) == 5);
+        REQUIRE(blob.Get() != nullptr);
+    }
+}
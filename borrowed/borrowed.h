@@ -0,0 +1,97 @@
+#pragma once
+
+#include <intrusive/intrusive.h>
+#include <unique/unique.h>
+#include <weak/shared.h>
+#include <weak/weak.h>
+
+#include <cassert>
+#include <type_traits>
+
+// Non-owning view of an object owned by a `SharedPtr`, `IntrusivePtr` or `UniquePtr`,
+// for passing down a call stack without touching the reference count at every level.
+// The caller guarantees that an owner outlives the view.
+// In release builds a `Borrowed` is a plain pointer. In debug builds a view of a `SharedPtr`
+// also holds a weak reference and every access asserts that the object is still alive;
+// intrusive and unique owners have no separate block to consult, so they are not checked.
+template <typename T>
+class Borrowed {
+public:
+    template <typename Y>
+    friend class Borrowed;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    template <typename Y>
+        requires std::is_convertible_v<Y*, T*>
+    Borrowed(const SharedPtr<Y>& owner) : ptr_(owner.Get()) {
+#ifndef NDEBUG
+        owner_ = WeakPtr<T>(owner);
+        checked_ = static_cast<bool>(owner);
+#endif
+    }
+    template <typename Y>
+        requires std::is_convertible_v<Y*, T*>
+    Borrowed(const IntrusivePtr<Y>& owner) noexcept : ptr_(owner.Get()) {
+    }
+    template <typename Y, typename Deleter>
+        requires std::is_convertible_v<Y*, T*>
+    Borrowed(const UniquePtr<Y, Deleter>& owner) noexcept : ptr_(owner.Get()) {
+    }
+    template <typename Y>
+        requires std::is_convertible_v<Y*, T*>
+    Borrowed(const Borrowed<Y>& other) : ptr_(other.ptr_) {
+#ifndef NDEBUG
+        // `WeakPtr` has no converting constructor, so go through a short-lived owner
+        owner_ = WeakPtr<T>(other.owner_.TryLock());
+        checked_ = other.checked_;
+#endif
+    }
+
+    // Owners that are about to die cannot be borrowed from
+    template <typename Y>
+    Borrowed(SharedPtr<Y>&&) = delete;
+    template <typename Y>
+    Borrowed(IntrusivePtr<Y>&&) = delete;
+    template <typename Y, typename Deleter>
+    Borrowed(UniquePtr<Y, Deleter>&&) = delete;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    T* Get() const noexcept {
+        CheckAlive();
+        return ptr_;
+    };
+    T& operator*() const noexcept {
+        CheckAlive();
+        return *ptr_;
+    };
+    T* operator->() const noexcept {
+        CheckAlive();
+        return ptr_;
+    };
+    explicit operator bool() const noexcept {
+        return ptr_ != nullptr;
+    };
+
+private:
+    void CheckAlive() const noexcept {
+#ifndef NDEBUG
+        assert((!checked_ || !owner_.Expired()) && "Borrowed object outlived its owners");
+#endif
+    }
+
+    T* ptr_;
+#ifndef NDEBUG
+    // Keeps the control block readable after the owners are gone
+    WeakPtr<T> owner_;
+    bool checked_ = false;
+#endif
+};
+
+template <typename T, typename U>
+inline bool operator==(const Borrowed<T>& left, const Borrowed<U>& right) {
+    return left.Get() == right.Get();
+};
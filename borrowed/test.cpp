@@ -0,0 +1,100 @@
+#include "borrowed.h"
+
+#include <catch.hpp>
+
+#include "allocations_checker.h"
+
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Shape {
+    virtual ~Shape() = default;
+    virtual int Area() const = 0;
+};
+
+struct Square : Shape {
+    explicit Square(int side) : side(side) {
+    }
+    int Area() const override {
+        return side * side;
+    }
+
+    int side;
+};
+
+struct Document : SimpleRefCounted<Document> {
+    std::string title;
+};
+
+int AreaOf(Borrowed<const Shape> shape) {
+    return shape->Area();
+}
+
+#ifdef NDEBUG
+static_assert(sizeof(Borrowed<int>) == sizeof(int*));
+#endif
+
+TEST_CASE("Borrowed") {
+    SECTION("From SharedPtr") {
+        auto square = MakeShared<Square>(3);
+        Borrowed<Square> borrowed = square;
+
+        REQUIRE(borrowed.Get() == square.Get());
+        REQUIRE(borrowed->side == 3);
+        REQUIRE(AreaOf(square) == 9);
+        REQUIRE(AreaOf(borrowed) == 9);
+        REQUIRE(square.UseCount() == 1);
+    }
+
+    SECTION("From IntrusivePtr") {
+        auto document = MakeIntrusive<Document>();
+        document->title = "notes";
+        Borrowed<Document> borrowed = document;
+
+        REQUIRE((*borrowed).title == "notes");
+        REQUIRE(document->RefCount() == 1);
+    }
+
+    SECTION("From UniquePtr") {
+        UniquePtr<Shape> shape(new Square(4));
+        Borrowed<Shape> borrowed = shape;
+
+        REQUIRE(borrowed.Get() == shape.Get());
+        REQUIRE(AreaOf(shape) == 16);
+    }
+
+    SECTION("Empty owners") {
+        SharedPtr<int> shared;
+        IntrusivePtr<Document> intrusive;
+        Borrowed<int> from_shared = shared;
+        Borrowed<Document> from_intrusive = intrusive;
+
+        REQUIRE(!from_shared);
+        REQUIRE(!from_intrusive);
+        REQUIRE(from_shared.Get() == nullptr);
+    }
+
+    SECTION("Temporaries cannot be borrowed") {
+        static_assert(!std::is_constructible_v<Borrowed<int>, SharedPtr<int>&&>);
+        static_assert(!std::is_constructible_v<Borrowed<Document>, IntrusivePtr<Document>&&>);
+        static_assert(!std::is_constructible_v<Borrowed<int>, UniquePtr<int>&&>);
+    }
+
+    SECTION("No counter updates or allocations") {
+        auto square = MakeShared<Square>(2);
+        auto document = MakeIntrusive<Document>();
+
+        EXPECT_ZERO_ALLOCATIONS(Borrowed<Square>{square});
+        EXPECT_ZERO_ALLOCATIONS(Borrowed<Document>{document});
+        REQUIRE(document->RefCount() == 1);
+    }
+
+    SECTION("Equality") {
+        auto square = MakeShared<Square>(5);
+        Borrowed<Square> a = square;
+        Borrowed<const Shape> b = a;
+
+        REQUIRE(a == b);
+    }
+}
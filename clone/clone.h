@@ -0,0 +1,237 @@
+#pragma once
+
+#include <unique/unique.h>
+
+#include <cstddef>  // std::nullptr_t, std::max_align_t
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Operations on the concrete type an object was created with.
+// One table per (T, U, placement) is instantiated at compile time, so copying a `ClonePtr`
+// is a single indirect call into code generated by us, not a virtual `Clone()` of the user.
+template <typename T>
+struct CloneOps {
+    // Copies `object` into `buffer` (inline table) or onto the heap (heap table).
+    T* (*copy)(const T* object, void* buffer);
+    // Moves an inline `object` into `buffer` and destroys the source. Unused for heap objects.
+    T* (*relocate)(T* object, void* buffer);
+    // Destroys `object` and frees its memory if it lives on the heap.
+    void (*destroy)(T* object);
+    bool is_inline;
+};
+
+template <typename T, typename U>
+struct HeapCloneOps {
+    static T* Copy(const T* object, void*) {
+        return new U(*static_cast<const U*>(object));
+    }
+    static void Destroy(T* object) {
+        delete static_cast<U*>(object);
+    }
+
+    static constexpr CloneOps<T> kTable{&Copy, nullptr, &Destroy, false};
+};
+
+template <typename T, typename U>
+struct InlineCloneOps {
+    static T* Copy(const T* object, void* buffer) {
+        return ::new (buffer) U(*static_cast<const U*>(object));
+    }
+    static T* Relocate(T* object, void* buffer) {
+        U* source = static_cast<U*>(object);
+        T* result = ::new (buffer) U(std::move(*source));
+        source->~U();
+        return result;
+    }
+    static void Destroy(T* object) {
+        static_cast<U*>(object)->~U();
+    }
+
+    static constexpr CloneOps<T> kTable{&Copy, &Relocate, &Destroy, true};
+};
+
+// Deleter for `UniquePtr` that also remembers how to copy the object.
+template <typename T>
+class CloneDeleter {
+public:
+    CloneDeleter() = default;
+    explicit CloneDeleter(const CloneOps<T>* ops) : ops_(ops) {
+    }
+
+    void operator()(T* object) const {
+        if (object != nullptr) {
+            ops_->destroy(object);
+        }
+    }
+
+    const CloneOps<T>* GetOps() const {
+        return ops_;
+    }
+
+private:
+    const CloneOps<T>* ops_ = nullptr;
+};
+
+// Copyable owning pointer: copies deep-copy the pointee with its dynamic type.
+// Objects of at most `InlineCapacity` bytes that are nothrow movable are stored inside the
+// `ClonePtr` itself, so copying them does not allocate.
+template <typename T, size_t InlineCapacity = 0>
+class ClonePtr {
+public:
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    ClonePtr() noexcept = default;
+    ClonePtr(std::nullptr_t) noexcept {
+    }
+
+    // Adopt a heap object. Its copy operation is taken from the static type `U`.
+    template <typename U>
+    explicit ClonePtr(U* ptr) : ptr_(ptr, CloneDeleter<T>(&HeapCloneOps<T, U>::kTable)) {
+        static_assert(std::is_convertible_v<U*, T*>);
+        static_assert(std::is_copy_constructible_v<U>);
+    };
+
+    ClonePtr(const ClonePtr& other) {
+        if (other) {
+            const CloneOps<T>* ops = other.GetOps();
+            Adopt(ops->copy(other.Get(), buffer_.Data()), ops);
+        }
+    };
+    ClonePtr(ClonePtr&& other) noexcept {
+        this->TakeFrom(other);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // `operator=`-s
+
+    ClonePtr& operator=(const ClonePtr& other) {
+        if (this == &other) {
+            return *this;
+        }
+        ClonePtr copy(other);
+        this->Reset();
+        this->TakeFrom(copy);
+        return *this;
+    };
+    ClonePtr& operator=(ClonePtr&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        this->Reset();
+        this->TakeFrom(other);
+        return *this;
+    };
+    ClonePtr& operator=(std::nullptr_t) noexcept {
+        this->Reset();
+        return *this;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Destructor
+
+    ~ClonePtr() = default;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Modifiers
+
+    // Construct a `U` in place, inline if it fits.
+    template <typename U = T, typename... Args>
+    U& Emplace(Args&&... args) {
+        static_assert(std::is_convertible_v<U*, T*>);
+        static_assert(std::is_copy_constructible_v<U>);
+        this->Reset();
+        if constexpr (kFitsInline<U>) {
+            U* object = ::new (buffer_.Data()) U(std::forward<Args>(args)...);
+            Adopt(object, &InlineCloneOps<T, U>::kTable);
+            return *object;
+        } else {
+            U* object = new U(std::forward<Args>(args)...);
+            Adopt(object, &HeapCloneOps<T, U>::kTable);
+            return *object;
+        }
+    };
+    void Reset() noexcept {
+        ptr_.Reset();
+    };
+    void Swap(ClonePtr& other) noexcept {
+        ClonePtr tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    T* Get() const noexcept {
+        return ptr_.Get();
+    };
+    T& operator*() const noexcept {
+        return *ptr_.Get();
+    };
+    T* operator->() const noexcept {
+        return ptr_.Get();
+    };
+    bool IsInline() const noexcept {
+        return *this && GetOps()->is_inline;
+    };
+    explicit operator bool() const noexcept {
+        return ptr_.Get() != nullptr;
+    };
+
+private:
+    template <typename U>
+    static constexpr bool kFitsInline =
+        sizeof(U) <= InlineCapacity && alignof(U) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible_v<U>;
+
+    const CloneOps<T>* GetOps() const noexcept {
+        return ptr_.GetDeleter().GetOps();
+    }
+
+    void Adopt(T* object, const CloneOps<T>* ops) noexcept {
+        ptr_ = UniquePtr<T, CloneDeleter<T>>(object, CloneDeleter<T>(ops));
+    }
+
+    // Expects `*this` to be empty.
+    void TakeFrom(ClonePtr& other) noexcept {
+        if (!other) {
+            return;
+        }
+        const CloneOps<T>* ops = other.GetOps();
+        if (ops->is_inline) {
+            T* object = ops->relocate(other.ptr_.Release(), buffer_.Data());
+            Adopt(object, ops);
+        } else {
+            ptr_ = std::move(other.ptr_);
+        }
+    }
+
+    struct NoBuffer {
+        void* Data() noexcept {
+            return nullptr;
+        }
+    };
+    struct InlineBuffer {
+        void* Data() noexcept {
+            return bytes;
+        }
+
+        alignas(std::max_align_t) unsigned char bytes[InlineCapacity];
+    };
+
+    UniquePtr<T, CloneDeleter<T>> ptr_;
+    // Heap-only pointers need no buffer.
+    [[no_unique_address]] std::conditional_t<InlineCapacity == 0, NoBuffer, InlineBuffer> buffer_;
+};
+
+// Heap-only pointers hold no object inside, so they can be moved as bytes
+template <typename T>
+struct IsTriviallyRelocatable<ClonePtr<T, 0>> : std::true_type {};
+
+// Creates a `U` and returns it as `ClonePtr<T>`.
+template <typename T, typename U = T, typename... Args>
+ClonePtr<T> MakeClone(Args&&... args) {
+    return ClonePtr<T>(new U(std::forward<Args>(args)...));
+};
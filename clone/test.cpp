@@ -0,0 +1,179 @@
+#include "clone.h"
+
+#include <catch.hpp>
+
+#include "allocations_checker.h"
+
+#include <common/my_int.h>
+
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Shape {
+    virtual ~Shape() = default;
+    virtual int Area() const = 0;
+};
+
+struct Square : Shape {
+    explicit Square(int side) : side(side) {
+    }
+    int Area() const override {
+        return side * side;
+    }
+
+    int side;
+};
+
+struct Rectangle : Shape {
+    Rectangle(int width, int height) : width(width), height(height) {
+    }
+    int Area() const override {
+        return width * height;
+    }
+
+    int width;
+    int height;
+    std::string name = "a rectangle with a name long enough to live on the heap";
+};
+
+TEST_CASE("Copying") {
+    SECTION("Deep copy") {
+        {
+            ClonePtr<MyInt> a = MakeClone<MyInt>(42);
+            ClonePtr<MyInt> b = a;
+
+            REQUIRE(MyInt::AliveCount() == 2);
+            REQUIRE(a.Get() != b.Get());
+            REQUIRE(*b == 42);
+        }
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Dynamic type is preserved") {
+        ClonePtr<Shape> a = MakeClone<Shape, Rectangle>(2, 3);
+        ClonePtr<Shape> b(new Square(4));
+        ClonePtr<Shape> c = a;
+        ClonePtr<Shape> d;
+        d = b;
+
+        REQUIRE(dynamic_cast<Rectangle*>(c.Get()) != nullptr);
+        REQUIRE(c->Area() == 6);
+        REQUIRE(dynamic_cast<Square*>(d.Get()) != nullptr);
+        REQUIRE(d->Area() == 16);
+    }
+
+    SECTION("Copy of empty") {
+        ClonePtr<Shape> a;
+        ClonePtr<Shape> b = a;
+        ClonePtr<Shape> c = MakeClone<Shape, Square>(1);
+        c = a;
+
+        REQUIRE(!b);
+        REQUIRE(!c);
+    }
+
+    SECTION("Self assignment") {
+        ClonePtr<MyInt> a = MakeClone<MyInt>(1);
+        MyInt* p = a.Get();
+        a = a;
+        a = std::move(a);
+
+        REQUIRE(a.Get() == p);
+        REQUIRE(MyInt::AliveCount() == 1);
+    }
+
+    SECTION("Container of clones") {
+        std::vector<ClonePtr<Shape>> shapes;
+        shapes.push_back(MakeClone<Shape, Square>(2));
+        shapes.push_back(MakeClone<Shape, Rectangle>(2, 5));
+        std::vector<ClonePtr<Shape>> copy = shapes;
+
+        REQUIRE(copy[0]->Area() == 4);
+        REQUIRE(copy[1]->Area() == 10);
+        REQUIRE(copy[1].Get() != shapes[1].Get());
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Moving") {
+    SECTION("Move does not copy") {
+        ClonePtr<MyInt> a = MakeClone<MyInt>(7);
+        MyInt* p = a.Get();
+        ClonePtr<MyInt> b = std::move(a);
+
+        REQUIRE(!a);
+        REQUIRE(b.Get() == p);
+        REQUIRE(MyInt::AliveCount() == 1);
+    }
+
+    SECTION("Noexcept") {
+        static_assert(std::is_nothrow_move_constructible_v<ClonePtr<Shape>>);
+        static_assert(std::is_nothrow_move_assignable_v<ClonePtr<Shape>>);
+        static_assert(std::is_nothrow_move_constructible_v<ClonePtr<Shape, 16>>);
+    }
+
+    SECTION("Swap") {
+        ClonePtr<Shape, 16> a;
+        a.Emplace<Square>(3);
+        ClonePtr<Shape, 16> b;
+        b.Emplace<Rectangle>(1, 2);
+        a.Swap(b);
+
+        REQUIRE(a->Area() == 2);
+        REQUIRE(b->Area() == 9);
+        REQUIRE(b.IsInline());
+        REQUIRE(!a.IsInline());
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+using SmallShapePtr = ClonePtr<Shape, 16>;
+
+TEST_CASE("Inline storage") {
+    SECTION("Sizeof") {
+        static_assert(sizeof(ClonePtr<Shape>) == 2 * sizeof(void*));
+    }
+
+    SECTION("Small objects stay inline") {
+        SmallShapePtr a;
+        a.Emplace<Square>(5);
+        REQUIRE(a.IsInline());
+
+        EXPECT_ZERO_ALLOCATIONS(SmallShapePtr b = a; REQUIRE(b.IsInline());
+                                REQUIRE(b->Area() == 25));
+    }
+
+    SECTION("Big objects go to the heap") {
+        ClonePtr<Shape, 16> a;
+        a.Emplace<Rectangle>(3, 4);
+        REQUIRE(!a.IsInline());
+
+        ClonePtr<Shape, 16> b = a;
+        REQUIRE(b->Area() == 12);
+    }
+
+    SECTION("Move of inline object") {
+        ClonePtr<Shape, 16> a;
+        a.Emplace<Square>(3);
+        ClonePtr<Shape, 16> b = a;
+        ClonePtr<Shape, 16> c = std::move(a);
+
+        REQUIRE(!a);
+        REQUIRE(c.IsInline());
+        REQUIRE(c->Area() == 9);
+        c = std::move(b);
+        REQUIRE(c->Area() == 9);
+    }
+
+    SECTION("Types without nothrow move go to the heap") {
+        ClonePtr<MyInt, 16> a;
+        a.Emplace(3);
+
+        REQUIRE(!a.IsInline());
+        REQUIRE(*a == 3);
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <concepts>
+
+// `dynamic_cast` without RTTI for closed hierarchies.
+// The root class stores a kind tag and every class that can be a cast target answers
+// "is this object one of mine" from it:
+//
+//     struct Shape { enum Kind { kCircle, kSquare } kind; };
+//     struct Circle : Shape {
+//         static bool ClassOf(const Shape* shape) { return shape->kind == kCircle; }
+//     };
+//
+// A check is a load and a compare instead of a walk over type_info.
+template <typename U, typename T>
+concept HasClassOf = requires(const T* ptr) {
+    { U::ClassOf(ptr) } -> std::convertible_to<bool>;
+};
+
+template <typename U, typename T>
+    requires HasClassOf<U, T>
+U* FastDynamicCast(T* ptr) noexcept {
+    if (ptr == nullptr || !U::ClassOf(ptr)) {
+        return nullptr;
+    }
+    return static_cast<U*>(ptr);
+}
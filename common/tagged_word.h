@@ -0,0 +1,52 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstddef>  // size_t
+#include <cstdint>  // uintptr_t
+
+// A `T*` and a few bits of user data packed into one word.
+// Every `T` is aligned to `alignof(T)`, so the low log2(alignof(T)) bits of its address are
+// always zero and can carry the tag.
+// `alignof(T)` is only read inside member functions, so `T` may be incomplete where a
+// `TaggedWord<T>` member is declared (e.g. tree nodes pointing to their children).
+template <typename T>
+class TaggedWord {
+public:
+    static constexpr size_t TagBits() noexcept {
+        return std::countr_zero(alignof(T));
+    }
+    static constexpr uintptr_t TagMask() noexcept {
+        return (uintptr_t{1} << TagBits()) - 1;
+    }
+
+    TaggedWord() noexcept = default;
+    TaggedWord(T* ptr, uintptr_t tag) noexcept {
+        SetPointer(ptr);
+        SetTag(tag);
+    }
+
+    T* GetPointer() const noexcept {
+        return reinterpret_cast<T*>(word_ & ~TagMask());
+    }
+    uintptr_t GetTag() const noexcept {
+        return word_ & TagMask();
+    }
+
+    void SetPointer(T* ptr) noexcept {
+        uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+        assert((address & TagMask()) == 0);
+        word_ = address | GetTag();
+    }
+    void SetTag(uintptr_t tag) noexcept {
+        assert(tag <= TagMask());
+        word_ = (word_ & ~TagMask()) | tag;
+    }
+
+    bool operator==(const TaggedWord& other) const noexcept {
+        return word_ == other.word_;
+    }
+
+private:
+    uintptr_t word_ = 0;
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <type_traits>
+
+// A type is trivially relocatable if moving an object to a new address and destroying the
+// source is equivalent to copying its bytes. Containers may then grow with `memcpy` and skip
+// the destructor of the moved-from element.
+// Specialize for types that own resources but hold no pointers into themselves.
+template <typename T>
+struct IsTriviallyRelocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+template <typename T>
+inline constexpr bool kIsTriviallyRelocatable = IsTriviallyRelocatable<T>::value;
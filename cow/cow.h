@@ -0,0 +1,79 @@
+#pragma once
+
+#include <shared/shared.h>
+
+#include <common/trivially_relocatable.h>
+
+#include <cstddef>  // size_t, std::nullptr_t
+#include <utility>
+
+// Copy-on-write value: copies share one `SharedPtr` and the value is cloned only when
+// a shared copy is about to be modified.
+// Reading is as cheap as through `SharedPtr`; a snapshot is one reference count increment.
+// The value is cloned as `T`, so `T` must be copy constructible and should not be a base class.
+template <typename T>
+class CowPtr {
+public:
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    CowPtr() noexcept = default;
+    CowPtr(std::nullptr_t) noexcept {
+    }
+    explicit CowPtr(SharedPtr<T> ptr) noexcept : ptr_(std::move(ptr)) {
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Modifiers
+
+    // Pointer to a value owned by this copy alone, cloned first if it is shared
+    T* Mutable() {
+        if (ptr_ && ptr_.UseCount() > 1) {
+            ptr_ = MakeShared<T>(std::as_const(*ptr_));
+        }
+        return ptr_.Get();
+    };
+    T& Write() {
+        return *Mutable();
+    };
+    void Reset() noexcept {
+        ptr_.Reset();
+    };
+    void Swap(CowPtr& other) noexcept {
+        ptr_.Swap(other.ptr_);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    const T* Get() const noexcept {
+        return ptr_.Get();
+    };
+    const T& operator*() const noexcept {
+        return *ptr_;
+    };
+    const T* operator->() const noexcept {
+        return ptr_.Get();
+    };
+    size_t UseCount() const noexcept {
+        return ptr_.UseCount();
+    };
+    bool IsShared() const noexcept {
+        return ptr_.UseCount() > 1;
+    };
+    explicit operator bool() const noexcept {
+        return static_cast<bool>(ptr_);
+    };
+
+private:
+    SharedPtr<T> ptr_;
+};
+
+template <typename T>
+struct IsTriviallyRelocatable<CowPtr<T>> : std::true_type {};
+
+// Allocate memory only once
+template <typename T, typename... Args>
+CowPtr<T> MakeCow(Args&&... args) {
+    return CowPtr<T>(MakeShared<T>(std::forward<Args>(args)...));
+};
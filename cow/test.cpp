@@ -0,0 +1,88 @@
+#include "cow.h"
+
+#include <catch.hpp>
+
+#include "allocations_checker.h"
+
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("CowPtr") {
+    SECTION("Empty") {
+        CowPtr<int> empty;
+
+        REQUIRE(!empty);
+        REQUIRE(empty.Get() == nullptr);
+        REQUIRE(empty.Mutable() == nullptr);
+        REQUIRE(empty.UseCount() == 0);
+    }
+
+    SECTION("Copies share the value") {
+        auto a = MakeCow<std::vector<int>>(1000, 7);
+        CowPtr<std::vector<int>> b;
+        EXPECT_ZERO_ALLOCATIONS(b = a);
+
+        REQUIRE(a.Get() == b.Get());
+        REQUIRE(a.IsShared());
+        REQUIRE(b.UseCount() == 2);
+    }
+
+    SECTION("Reading does not clone") {
+        auto a = MakeCow<std::string>("value");
+        auto b = a;
+
+        REQUIRE(*b == "value");
+        REQUIRE(b->size() == 5);
+        REQUIRE(a.Get() == b.Get());
+    }
+
+    SECTION("Writing to a shared value clones it") {
+        auto a = MakeCow<std::string>("value");
+        auto b = a;
+        const std::string* old = a.Get();
+
+        EXPECT_ONE_ALLOCATION(b.Write() += "!");
+
+        REQUIRE(*a == "value");
+        REQUIRE(*b == "value!");
+        REQUIRE(a.Get() == old);
+        REQUIRE_FALSE(a.IsShared());
+        REQUIRE_FALSE(b.IsShared());
+    }
+
+    SECTION("Writing to a unique value does not clone") {
+        auto a = MakeCow<int>(1);
+        const int* old = a.Get();
+
+        EXPECT_ZERO_ALLOCATIONS(*a.Mutable() = 2);
+
+        REQUIRE(*a == 2);
+        REQUIRE(a.Get() == old);
+    }
+
+    SECTION("Snapshots") {
+        auto state = MakeCow<std::vector<int>>();
+        std::vector<CowPtr<std::vector<int>>> versions;
+        for (int i = 0; i < 5; ++i) {
+            versions.push_back(state);
+            state.Write().push_back(i);
+        }
+
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(versions[i]->size() == static_cast<size_t>(i));
+        }
+        REQUIRE(state->size() == 5);
+    }
+
+    SECTION("From an existing SharedPtr") {
+        auto shared = MakeShared<int>(1);
+        CowPtr<int> cow(shared);
+
+        cow.Write() = 2;
+
+        REQUIRE(*shared == 1);
+        REQUIRE(*cow == 2);
+    }
+}
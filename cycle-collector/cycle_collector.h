@@ -0,0 +1,299 @@
+#pragma once
+
+#include <intrusive/intrusive.h>
+
+#include <algorithm>
+#include <cstddef>  // size_t
+#include <cstdint>  // uint8_t
+#include <new>
+#include <vector>
+
+// Opt-in collection of reference cycles between `IntrusivePtr`-owned objects, with the
+// synchronous trial deletion of Bacon and Rajan ("Concurrent Cycle Collection in Reference
+// Counted Systems", 2001). A decrement that leaves a nonzero count buffers the object as
+// a possible root of a garbage cycle; the collector then subtracts the references inside
+// the subgraph reachable from the roots, and what is left at zero is referenced only from
+// inside that subgraph and is freed.
+//
+// Types derive from `CycleCollected<Derived>` and tell the collector their edges through
+// `EdgeTraits<Derived>`; by default it calls `Derived::VisitEdges(visit)`, which has to pass
+// every `IntrusivePtr` member that points to a `CycleCollected` object to `visit`.
+// Counting is not atomic: the objects of a graph and their collector stay on one thread,
+// and are released before the thread exits.
+
+class CycleNode;
+
+// Buffers possible roots and collects them, one instance per thread
+class CycleCollector {
+public:
+    CycleCollector() = default;
+    CycleCollector(const CycleCollector&) = delete;
+    CycleCollector& operator=(const CycleCollector&) = delete;
+    ~CycleCollector() {
+        Collect();
+    };
+
+    static CycleCollector& Current() {
+        thread_local CycleCollector collector;
+        return collector;
+    };
+
+    // Examines every buffered root
+    void Collect() {
+        CollectSome(roots_.size());
+    };
+    // Examines at most `count` of the oldest roots: collection runs in steps of bounded size,
+    // each step is still complete for the cycles it finds
+    void CollectSome(size_t count);
+
+    // The buffer of roots is collected whenever it reaches `threshold`,
+    // which bounds the memory held by garbage cycles. Zero turns it off.
+    void SetThreshold(size_t threshold) noexcept {
+        threshold_ = threshold;
+    };
+    size_t BufferedRoots() const noexcept {
+        return roots_.size();
+    };
+
+private:
+    friend class CycleNode;
+
+    void PossibleRoot(CycleNode* node);
+
+    std::vector<CycleNode*> roots_;
+    size_t threshold_ = 10'000;
+    bool collecting_ = false;
+};
+
+// Counter and collector state of an object, the type-erased half of `CycleCollected`
+class CycleNode {
+public:
+    void IncRef() noexcept {
+        ++count_;
+        color_ = Color::kBlack;
+    };
+    // Frees the object at zero, otherwise buffers it as a possible root of a cycle
+    void DecRef() {
+        if (color_ == Color::kFreeing) {
+            return;
+        }
+        if (--count_ == 0) {
+            color_ = Color::kBlack;
+            if (!buffered_) {
+                delete this;
+            }
+            // A buffered object is freed when the collector drops it from the buffer
+            return;
+        }
+        CycleCollector::Current().PossibleRoot(this);
+    };
+    size_t RefCount() const noexcept {
+        return count_;
+    };
+
+protected:
+    CycleNode() = default;
+    // A copy of an object is a new object, it does not inherit the references of the source
+    CycleNode(const CycleNode&) noexcept {
+    }
+    CycleNode& operator=(const CycleNode&) noexcept {
+        return *this;
+    }
+    virtual ~CycleNode() = default;
+
+    using Visitor = void (*)(CycleNode* child, void* context);
+    // Calls `visit` for every non-null child, implemented by `CycleCollected`
+    virtual void VisitChildren(Visitor visit, void* context) = 0;
+    // Resets every edge, implemented by `CycleCollected`
+    virtual void ReleaseChildren() = 0;
+
+private:
+    friend class CycleCollector;
+
+    enum class Color : uint8_t {
+        kBlack,    // In use or free
+        kGray,     // Possible member of a cycle
+        kWhite,    // Member of a garbage cycle
+        kPurple,   // Possible root of a cycle
+        kFreeing,  // Member of a garbage cycle being freed, its references are not counted
+    };
+
+    template <typename F>
+    void ForEachChild(F f) {
+        VisitChildren([](CycleNode* child, void* context) { (*static_cast<F*>(context))(child); },
+                      &f);
+    }
+
+    size_t count_ = 0;
+    Color color_ = Color::kBlack;
+    bool buffered_ = false;
+};
+
+// Specialize to describe the edges of a type without a `VisitEdges` member
+template <typename T>
+struct EdgeTraits {
+    template <typename Visit>
+    static void VisitEdges(T& object, Visit&& visit) {
+        object.VisitEdges(visit);
+    }
+};
+
+template <typename Derived>
+class CycleCollected : public CycleNode {
+private:
+    void VisitChildren(Visitor visit, void* context) final {
+        EdgeTraits<Derived>::VisitEdges(static_cast<Derived&>(*this),
+                                        [visit, context](const auto& edge) {
+                                            if (edge) {
+                                                visit(edge.Get(), context);
+                                            }
+                                        });
+    }
+    void ReleaseChildren() final {
+        EdgeTraits<Derived>::VisitEdges(static_cast<Derived&>(*this),
+                                        [](auto& edge) { edge.Reset(); });
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Trial deletion
+// The recursive procedures of the paper run on explicit stacks, so long chains are fine.
+
+inline void CycleCollector::PossibleRoot(CycleNode* node) {
+    if (node->color_ == CycleNode::Color::kPurple) {
+        return;
+    }
+    node->color_ = CycleNode::Color::kPurple;
+    if (!node->buffered_) {
+        node->buffered_ = true;
+        roots_.push_back(node);
+        if (threshold_ != 0 && roots_.size() >= threshold_ && !collecting_) {
+            Collect();
+        }
+    }
+}
+
+inline void CycleCollector::CollectSome(size_t count) {
+    using Color = CycleNode::Color;
+    if (collecting_ || count == 0) {
+        return;
+    }
+    collecting_ = true;
+
+    // Frees of the objects below buffer new roots, keep them apart from this step
+    count = std::min(count, roots_.size());
+    std::vector<CycleNode*> roots(roots_.begin(), roots_.begin() + count);
+    roots_.erase(roots_.begin(), roots_.begin() + count);
+    std::vector<CycleNode*> stack;
+    // Dead roots are freed at the end, their destructors must not run into the marking
+    std::vector<CycleNode*> dead;
+
+    // Mark roots: subtract the counts of the edges inside the subgraph of every purple root
+    std::vector<CycleNode*> marked;
+    for (CycleNode* root : roots) {
+        if (root->color_ == Color::kPurple && root->count_ > 0) {
+            marked.push_back(root);
+            stack.push_back(root);
+            while (!stack.empty()) {
+                CycleNode* node = stack.back();
+                stack.pop_back();
+                if (node->color_ == Color::kGray) {
+                    continue;
+                }
+                node->color_ = Color::kGray;
+                node->ForEachChild([&stack](CycleNode* child) {
+                    --child->count_;
+                    stack.push_back(child);
+                });
+            }
+        } else {
+            root->buffered_ = false;
+            if (root->color_ == Color::kBlack && root->count_ == 0) {
+                dead.push_back(root);
+            }
+        }
+    }
+
+    // Scan roots: objects still referenced from outside and everything they reach are live,
+    // their counts are restored; the rest is white
+    auto scan_black = [&stack](CycleNode* start) {
+        start->color_ = Color::kBlack;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            CycleNode* node = stack.back();
+            stack.pop_back();
+            node->ForEachChild([&stack](CycleNode* child) {
+                ++child->count_;
+                if (child->color_ != Color::kBlack) {
+                    child->color_ = Color::kBlack;
+                    stack.push_back(child);
+                }
+            });
+        }
+    };
+    std::vector<CycleNode*> scan;
+    for (CycleNode* root : marked) {
+        scan.push_back(root);
+        while (!scan.empty()) {
+            CycleNode* node = scan.back();
+            scan.pop_back();
+            if (node->color_ != Color::kGray) {
+                continue;
+            }
+            if (node->count_ > 0) {
+                scan_black(node);
+                continue;
+            }
+            node->color_ = Color::kWhite;
+            node->ForEachChild([&scan](CycleNode* child) { scan.push_back(child); });
+        }
+    }
+
+    // Collect roots: gather the white objects. A white object may still be buffered
+    // for a later step, it leaves the buffer with the rest of its cycle.
+    for (CycleNode* root : marked) {
+        root->buffered_ = false;
+    }
+    std::vector<CycleNode*> garbage;
+    bool buffered_garbage = false;
+    for (CycleNode* root : marked) {
+        stack.push_back(root);
+        while (!stack.empty()) {
+            CycleNode* node = stack.back();
+            stack.pop_back();
+            if (node->color_ != Color::kWhite) {
+                continue;
+            }
+            node->color_ = Color::kFreeing;
+            buffered_garbage |= node->buffered_;
+            garbage.push_back(node);
+            node->ForEachChild([&stack](CycleNode* child) { stack.push_back(child); });
+        }
+    }
+    if (buffered_garbage) {
+        std::erase_if(roots_,
+                      [](CycleNode* node) { return node->color_ == Color::kFreeing; });
+    }
+
+    // The count of each edge out of the garbage was subtracted above and is given back here,
+    // so that its release is counted once. All edges are released before any destructor runs:
+    // `DecRef` ignores the garbage, and no destructor reaches an object destroyed before it.
+    for (CycleNode* node : garbage) {
+        node->ForEachChild([](CycleNode* child) {
+            if (child->color_ != Color::kFreeing) {
+                ++child->count_;
+            }
+        });
+    }
+    for (CycleNode* node : garbage) {
+        node->ReleaseChildren();
+    }
+    for (CycleNode* node : garbage) {
+        delete node;
+    }
+
+    collecting_ = false;
+    for (CycleNode* node : dead) {
+        delete node;
+    }
+}
@@ -0,0 +1,188 @@
+#include "cycle_collector.h"
+
+#include <catch.hpp>
+
+#include <cstddef>  // size_t
+#include <new>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Plugin : CycleCollected<Plugin> {
+    explicit Plugin(std::string name = "") : name(std::move(name)) {
+        ++alive;
+    }
+    ~Plugin() {
+        --alive;
+    }
+
+    template <typename Visit>
+    void VisitEdges(Visit&& visit) {
+        for (auto& dependency : dependencies) {
+            visit(dependency);
+        }
+    }
+
+    static inline int alive = 0;
+
+    std::string name;
+    std::vector<IntrusivePtr<Plugin>> dependencies;
+};
+
+// Edges described by traits instead of a member
+struct Pair : CycleCollected<Pair> {
+    IntrusivePtr<Pair> first;
+    IntrusivePtr<Plugin> second;
+};
+
+template <>
+struct EdgeTraits<Pair> {
+    template <typename Visit>
+    static void VisitEdges(Pair& pair, Visit&& visit) {
+        visit(pair.first);
+        visit(pair.second);
+    }
+};
+
+// Garbage is freed through the operator delete of its class
+struct alignas(64) Aligned : CycleCollected<Aligned> {
+    static void* operator new(size_t size, std::align_val_t align) {
+        ++allocated;
+        return ::operator new(size, align);
+    }
+    static void operator delete(void* ptr, std::align_val_t align) noexcept {
+        --allocated;
+        ::operator delete(ptr, align);
+    }
+
+    template <typename Visit>
+    void VisitEdges(Visit&& visit) {
+        visit(next);
+    }
+
+    static inline int allocated = 0;
+
+    IntrusivePtr<Aligned> next;
+};
+
+TEST_CASE("Cycle collector") {
+    auto& collector = CycleCollector::Current();
+    collector.Collect();
+    Plugin::alive = 0;
+
+    SECTION("Acyclic objects are freed by counting") {
+        {
+            auto a = MakeIntrusive<Plugin>("a");
+            a->dependencies.push_back(MakeIntrusive<Plugin>("b"));
+        }
+        REQUIRE(Plugin::alive == 0);
+        REQUIRE(collector.BufferedRoots() == 0);
+    }
+
+    SECTION("A cycle is collected") {
+        {
+            auto a = MakeIntrusive<Plugin>("a");
+            auto b = MakeIntrusive<Plugin>("b");
+            a->dependencies.push_back(b);
+            b->dependencies.push_back(a);
+        }
+        REQUIRE(Plugin::alive == 2);
+        REQUIRE(collector.BufferedRoots() > 0);
+
+        collector.Collect();
+        REQUIRE(Plugin::alive == 0);
+        REQUIRE(collector.BufferedRoots() == 0);
+    }
+
+    SECTION("Referenced cycles survive") {
+        IntrusivePtr<Plugin> host = MakeIntrusive<Plugin>("host");
+        IntrusivePtr<Plugin> outside;
+        {
+            auto a = MakeIntrusive<Plugin>("a");
+            auto b = MakeIntrusive<Plugin>("b");
+            a->dependencies.push_back(b);
+            b->dependencies.push_back(a);
+            b->dependencies.push_back(host);
+            outside = b;
+        }
+        collector.Collect();
+
+        REQUIRE(Plugin::alive == 3);
+        REQUIRE(outside->dependencies[0]->name == "a");
+        REQUIRE(outside.UseCount() == 2);
+        REQUIRE(host.UseCount() == 2);
+
+        outside.Reset();
+        collector.Collect();
+        REQUIRE(Plugin::alive == 1);
+        REQUIRE(host.UseCount() == 1);
+    }
+
+    SECTION("Self references and traits") {
+        {
+            auto pair = MakeIntrusive<Pair>();
+            pair->first = pair;
+            pair->second = MakeIntrusive<Plugin>("leaf");
+        }
+        REQUIRE(Plugin::alive == 1);
+        collector.Collect();
+        REQUIRE(Plugin::alive == 0);
+    }
+
+    SECTION("Class-specific deallocation") {
+        {
+            auto a = MakeIntrusive<Aligned>();
+            auto b = MakeIntrusive<Aligned>();
+            a->next = b;
+            b->next = a;
+        }
+        REQUIRE(Aligned::allocated == 2);
+        collector.Collect();
+        REQUIRE(Aligned::allocated == 0);
+    }
+
+    SECTION("Long cycles") {
+        {
+            auto head = MakeIntrusive<Plugin>();
+            auto tail = head;
+            for (int i = 0; i < 100'000; ++i) {
+                auto next = MakeIntrusive<Plugin>();
+                tail->dependencies.push_back(next);
+                tail = next;
+            }
+            tail->dependencies.push_back(head);
+        }
+        collector.Collect();
+        REQUIRE(Plugin::alive == 0);
+    }
+
+    SECTION("Incremental steps") {
+        for (int i = 0; i < 10; ++i) {
+            auto a = MakeIntrusive<Plugin>();
+            auto b = MakeIntrusive<Plugin>();
+            a->dependencies.push_back(b);
+            b->dependencies.push_back(a);
+        }
+        REQUIRE(Plugin::alive == 20);
+
+        collector.CollectSome(5);
+        REQUIRE(Plugin::alive < 20);
+        REQUIRE(Plugin::alive > 0);
+        collector.Collect();
+        REQUIRE(Plugin::alive == 0);
+    }
+
+    SECTION("Threshold bounds the garbage") {
+        collector.SetThreshold(16);
+        for (int i = 0; i < 1000; ++i) {
+            auto a = MakeIntrusive<Plugin>();
+            a->dependencies.push_back(a);
+        }
+        REQUIRE(Plugin::alive <= 16);
+        REQUIRE(collector.BufferedRoots() < 16);
+        collector.SetThreshold(10'000);
+        collector.Collect();
+        REQUIRE(Plugin::alive == 0);
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <weak/shared.h>
+#include <weak/weak.h>
+
+#include <cstddef>  // size_t
+#include <functional>
+#include <unordered_map>
+#include <utility>
+
+// Table of all live interned values of type `T`: at most one value per equivalence class.
+// Entries are `WeakPtr`-s, so the table does not keep values alive, and a value removes its
+// own entry when its last owner releases it.
+// Not thread-safe, like `SharedPtr` itself.
+template <typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>>
+class InternTable {
+public:
+    static InternTable& Instance() {
+        static InternTable table;
+        return table;
+    }
+
+    InternTable(const InternTable&) = delete;
+    InternTable& operator=(const InternTable&) = delete;
+
+    // The live value equal to `T(args...)`, or a new one
+    template <typename... Args>
+    SharedPtr<const T> Intern(Args&&... args) {
+        T value(std::forward<Args>(args)...);
+        auto it = entries_.find(&value);
+        if (it != entries_.end()) {
+            SharedPtr<Node> node = it->second.Lock();
+            return SharedPtr<const T>(node, &node->value);
+        }
+        SharedPtr<Node> node = MakeShared<Node>(std::move(value));
+        entries_.emplace(&node->value, WeakPtr<Node>(node));
+        return SharedPtr<const T>(node, &node->value);
+    }
+
+    // Number of live interned values
+    size_t Size() const noexcept {
+        return entries_.size();
+    }
+
+private:
+    struct Node {
+        explicit Node(T&& value) : value(std::move(value)) {
+        }
+        ~Node() {
+            Instance().Remove(&value);
+        }
+
+        T value;
+    };
+
+    struct DerefHash {
+        size_t operator()(const T* value) const {
+            return Hash()(*value);
+        }
+    };
+    struct DerefEqual {
+        bool operator()(const T* left, const T* right) const {
+            return Equal()(*left, *right);
+        }
+    };
+
+    InternTable() = default;
+
+    // Only the entry of this very value, a node that failed to register has none
+    void Remove(const T* value) {
+        auto it = entries_.find(value);
+        if (it != entries_.end() && it->first == value) {
+            entries_.erase(it);
+        }
+    }
+
+    std::unordered_map<const T*, WeakPtr<Node>, DerefHash, DerefEqual> entries_;
+};
+
+// Returns the live value equal to `T(args...)` if there is one, otherwise a new shared value.
+// Equal interned values are the same object, so they can be compared by pointer.
+template <typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>,
+          typename... Args>
+SharedPtr<const T> MakeInterned(Args&&... args) {
+    return InternTable<T, Hash, Equal>::Instance().Intern(std::forward<Args>(args)...);
+}
@@ -0,0 +1,95 @@
+#include "interned.h"
+
+#include <catch.hpp>
+
+#include <cctype>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("MakeInterned") {
+    using Strings = InternTable<std::string>;
+
+    SECTION("Equal values are shared") {
+        auto a = MakeInterned<std::string>("symbol");
+        auto b = MakeInterned<std::string>(std::string("sym") + "bol");
+        auto c = MakeInterned<std::string>("other");
+
+        REQUIRE(a.Get() == b.Get());
+        REQUIRE(a.Get() != c.Get());
+        REQUIRE(*a == "symbol");
+        REQUIRE(a.UseCount() == 2);
+        REQUIRE(Strings::Instance().Size() == 2);
+    }
+
+    SECTION("Entries are removed with the last owner") {
+        auto a = MakeInterned<std::string>("symbol");
+        auto b = a;
+        REQUIRE(Strings::Instance().Size() == 1);
+
+        a.Reset();
+        REQUIRE(Strings::Instance().Size() == 1);
+        b.Reset();
+        REQUIRE(Strings::Instance().Size() == 0);
+    }
+
+    SECTION("A value can be interned again after it died") {
+        auto a = MakeInterned<std::string>("symbol");
+        a.Reset();
+        a = MakeInterned<std::string>("symbol");
+
+        REQUIRE(*a == "symbol");
+        REQUIRE(Strings::Instance().Size() == 1);
+    }
+
+    SECTION("Weak pointers outlive the entry") {
+        WeakPtr<const std::string> weak;
+        {
+            auto a = MakeInterned<std::string>("symbol");
+            weak = a;
+        }
+        REQUIRE(weak.Expired());
+        REQUIRE(Strings::Instance().Size() == 0);
+    }
+
+    SECTION("Tables are separate per type") {
+        auto number = MakeInterned<int>(1);
+        std::vector<SharedPtr<const int>> numbers;
+        for (int i = 0; i < 10; ++i) {
+            numbers.push_back(MakeInterned<int>(i % 3));
+        }
+
+        REQUIRE(number.Get() == numbers[1].Get());
+        REQUIRE(InternTable<int>::Instance().Size() == 3);
+        REQUIRE(Strings::Instance().Size() == 0);
+    }
+}
+
+std::string ToLower(const std::string& value) {
+    std::string lower;
+    for (char c : value) {
+        lower += static_cast<char>(std::tolower(c));
+    }
+    return lower;
+}
+
+struct CaseInsensitiveHash {
+    size_t operator()(const std::string& value) const {
+        return std::hash<std::string>()(ToLower(value));
+    }
+};
+
+struct CaseInsensitiveEqual {
+    bool operator()(const std::string& left, const std::string& right) const {
+        return ToLower(left) == ToLower(right);
+    }
+};
+
+TEST_CASE("Custom equivalence") {
+    auto a = MakeInterned<std::string, CaseInsensitiveHash, CaseInsensitiveEqual>("Key");
+    auto b = MakeInterned<std::string, CaseInsensitiveHash, CaseInsensitiveEqual>("KEY");
+
+    REQUIRE(a.Get() == b.Get());
+    REQUIRE(*b == "Key");
+}
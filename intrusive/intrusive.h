@@ -3,11 +3,17 @@
 #include <cstddef>  // for std::nullptr_t
 #include <utility>  // for std::exchange / std::swap
 
+#include <common/fast_dynamic_cast.h>
+#include <common/trivially_relocatable.h>
+
 class SimpleCounter {
 public:
     size_t IncRef() noexcept {
         return ++count_;
     };
+    size_t IncRef(size_t count) noexcept {
+        return count_ += count;
+    };
     size_t DecRef() noexcept {
         return --count_;
     };
@@ -29,14 +35,37 @@ struct DefaultDelete {
 template <typename Derived, typename Counter, typename Deleter>
 class RefCounted {
 public:
+    RefCounted() = default;
+
+    // A copy of an object is a new object, it does not inherit the references of the source.
+    RefCounted(const RefCounted&) noexcept {
+    }
+    RefCounted& operator=(const RefCounted&) noexcept {
+        return *this;
+    }
+
     // Increase reference counter.
     void IncRef() {
+        if (IsImmortal()) [[unlikely]] {
+            return;
+        }
         counter_.IncRef();
     };
 
+    // Increase reference counter by `count` in one step.
+    void IncRef(size_t count) {
+        if (IsImmortal()) [[unlikely]] {
+            return;
+        }
+        counter_.IncRef(count);
+    };
+
     // Decrease reference counter.
     // Destroy object using Deleter when the last instance dies.
     void DecRef() {
+        if (IsImmortal()) [[unlikely]] {
+            return;
+        }
         if (counter_.RefCount() < 2) {
             if (counter_.RefCount() == 1) {
                 counter_.DecRef();
@@ -52,7 +81,20 @@ public:
         return counter_.RefCount();
     };
 
+    // Stop counting references to this object: `IncRef` and `DecRef` only read the counter,
+    // and the object is never destroyed by its pointers. For statics and other objects
+    // that outlive every pointer; call it at creation, before the first `IntrusivePtr`.
+    // The mark is a huge bias on the counter, so `RefCount` of an immortal object is huge.
+    void MakeImmortal() {
+        counter_.IncRef(kImmortalRefCount);
+    };
+    bool IsImmortal() const {
+        return counter_.RefCount() >= kImmortalRefCount;
+    };
+
 private:
+    static constexpr size_t kImmortalRefCount = size_t{1} << (sizeof(size_t) * 8 - 2);
+
     Counter counter_;
 };
 
@@ -63,6 +105,12 @@ template <typename T>
 class IntrusivePtr {
     template <typename Y>
     friend class IntrusivePtr;
+    template <typename U, typename Y>
+    friend IntrusivePtr<U> StaticPointerCast(IntrusivePtr<Y>&& other) noexcept;
+    template <typename U, typename Y>
+    friend IntrusivePtr<U> DynamicPointerCast(IntrusivePtr<Y>&& other) noexcept;
+    template <typename U, typename Y>
+    friend IntrusivePtr<U> FastDynamicPointerCast(IntrusivePtr<Y>&& other) noexcept;
 
 public:
     // Constructors
@@ -94,11 +142,9 @@ public:
     };
 
     IntrusivePtr(const IntrusivePtr& other) noexcept {
-        if (object_ptr_ != other.object_ptr_) {
-            object_ptr_ = other.object_ptr_;
-            if (object_ptr_ != nullptr) {
-                object_ptr_->IncRef();
-            }
+        object_ptr_ = other.object_ptr_;
+        if (object_ptr_ != nullptr) {
+            object_ptr_->IncRef();
         }
     };
     IntrusivePtr(IntrusivePtr&& other) noexcept {
@@ -158,6 +204,36 @@ public:
     void Swap(IntrusivePtr& other) noexcept {
         std::swap(object_ptr_, other.object_ptr_);
     };
+    // Writes `count` copies of `*this` to `out` with a single counter update
+    // if `T` supports `IncRef(count)`.
+    template <typename OutputIt>
+    OutputIt ShareN(size_t count, OutputIt out) const {
+        if (object_ptr_ != nullptr && count > 0) {
+            if constexpr (requires(T* ptr) { ptr->IncRef(count); }) {
+                object_ptr_->IncRef(count);
+            } else {
+                for (size_t i = 0; i < count; ++i) {
+                    object_ptr_->IncRef();
+                }
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            // Adopts one of the references added above
+            IntrusivePtr copy;
+            copy.object_ptr_ = object_ptr_;
+            try {
+                *out = std::move(copy);
+            } catch (...) {
+                // `copy` gives back its own reference, return the ones not handed out yet
+                for (size_t j = i + 1; object_ptr_ != nullptr && j < count; ++j) {
+                    object_ptr_->DecRef();
+                }
+                throw;
+            }
+            ++out;
+        }
+        return out;
+    };
 
     // Observers
     T* Get() const noexcept {
@@ -183,6 +259,53 @@ private:
     T* object_ptr_;
 };
 
+template <typename T>
+struct IsTriviallyRelocatable<IntrusivePtr<T>> : std::true_type {};
+
+// Casts
+// The rvalue overloads move the reference from the source, the counter is not touched.
+// A failed dynamic cast returns an empty pointer and leaves the source as it was.
+// There is no `ConstPointerCast`: the counter of a const object cannot be changed.
+template <typename T, typename Y>
+IntrusivePtr<T> StaticPointerCast(const IntrusivePtr<Y>& other) noexcept {
+    return IntrusivePtr<T>(static_cast<T*>(other.Get()));
+}
+template <typename T, typename Y>
+IntrusivePtr<T> StaticPointerCast(IntrusivePtr<Y>&& other) noexcept {
+    IntrusivePtr<T> result;
+    result.object_ptr_ = static_cast<T*>(std::exchange(other.object_ptr_, nullptr));
+    return result;
+}
+
+template <typename T, typename Y>
+IntrusivePtr<T> DynamicPointerCast(const IntrusivePtr<Y>& other) noexcept {
+    return IntrusivePtr<T>(dynamic_cast<T*>(other.Get()));
+}
+template <typename T, typename Y>
+IntrusivePtr<T> DynamicPointerCast(IntrusivePtr<Y>&& other) noexcept {
+    IntrusivePtr<T> result;
+    result.object_ptr_ = dynamic_cast<T*>(other.object_ptr_);
+    if (result.object_ptr_ != nullptr) {
+        other.object_ptr_ = nullptr;
+    }
+    return result;
+}
+
+// `DynamicPointerCast` for closed hierarchies, see common/fast_dynamic_cast.h
+template <typename T, typename Y>
+IntrusivePtr<T> FastDynamicPointerCast(const IntrusivePtr<Y>& other) noexcept {
+    return IntrusivePtr<T>(FastDynamicCast<T>(other.Get()));
+}
+template <typename T, typename Y>
+IntrusivePtr<T> FastDynamicPointerCast(IntrusivePtr<Y>&& other) noexcept {
+    IntrusivePtr<T> result;
+    result.object_ptr_ = FastDynamicCast<T>(other.object_ptr_);
+    if (result.object_ptr_ != nullptr) {
+        other.object_ptr_ = nullptr;
+    }
+    return result;
+}
+
 template <typename T, typename... Args>
 IntrusivePtr<T> MakeIntrusive(Args&&... args) {
     T* ptr = new T(std::forward<Args>(args)...);
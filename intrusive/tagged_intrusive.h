@@ -0,0 +1,136 @@
+#pragma once
+
+#include "intrusive.h"
+
+#include <common/tagged_word.h>
+#include <common/trivially_relocatable.h>
+
+#include <cstddef>  // std::nullptr_t
+#include <cstdint>  // uintptr_t
+#include <utility>
+
+// `IntrusivePtr` that keeps a small tag in the alignment bits of the pointer.
+// Copies share the object and copy the tag; moves transfer both and clear the source.
+template <typename T>
+class TaggedIntrusivePtr {
+public:
+    // Constructors
+    TaggedIntrusivePtr() noexcept = default;
+    TaggedIntrusivePtr(std::nullptr_t) noexcept {
+    }
+    TaggedIntrusivePtr(T* ptr, uintptr_t tag = 0) noexcept : word_(ptr, tag) {
+        if (ptr != nullptr) {
+            ptr->IncRef();
+        }
+    };
+    TaggedIntrusivePtr(IntrusivePtr<T> ptr, uintptr_t tag = 0) noexcept : word_(ptr.Get(), tag) {
+        if (ptr) {
+            ptr->IncRef();
+        }
+    };
+
+    TaggedIntrusivePtr(const TaggedIntrusivePtr& other) noexcept : word_(other.word_) {
+        if (Get() != nullptr) {
+            Get()->IncRef();
+        }
+    };
+    TaggedIntrusivePtr(TaggedIntrusivePtr&& other) noexcept
+        : word_(std::exchange(other.word_, TaggedWord<T>())) {
+    }
+
+    // `operator=`-s
+    TaggedIntrusivePtr& operator=(const TaggedIntrusivePtr& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        if (other.Get() != nullptr) {
+            other.Get()->IncRef();
+        }
+        if (Get() != nullptr) {
+            Get()->DecRef();
+        }
+        word_ = other.word_;
+        return *this;
+    };
+    TaggedIntrusivePtr& operator=(TaggedIntrusivePtr&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        this->Swap(other);
+        other.Reset();
+        other.SetTag(0);
+        return *this;
+    };
+
+    // Destructor
+    ~TaggedIntrusivePtr() {
+        if (Get() != nullptr) {
+            Get()->DecRef();
+        }
+    };
+
+    // Modifiers
+    void Reset() noexcept {
+        if (Get() != nullptr) {
+            Get()->DecRef();
+            word_.SetPointer(nullptr);
+        }
+    };
+    void Reset(T* ptr) noexcept {
+        if (ptr != nullptr) {
+            ptr->IncRef();
+        }
+        T* old = Get();
+        word_.SetPointer(ptr);
+        if (old != nullptr) {
+            old->DecRef();
+        }
+    };
+    void SetTag(uintptr_t tag) noexcept {
+        word_.SetTag(tag);
+    };
+    void Swap(TaggedIntrusivePtr& other) noexcept {
+        std::swap(word_, other.word_);
+    };
+
+    // Observers
+    // Pointer with the tag bits cleared
+    T* Get() const noexcept {
+        return word_.GetPointer();
+    };
+    uintptr_t GetTag() const noexcept {
+        return word_.GetTag();
+    };
+    static constexpr size_t TagBits() noexcept {
+        return TaggedWord<T>::TagBits();
+    };
+    T& operator*() const noexcept {
+        return *Get();
+    };
+    T* operator->() const noexcept {
+        return Get();
+    };
+    size_t UseCount() const {
+        if (Get() != nullptr) {
+            return Get()->RefCount();
+        }
+        return 0;
+    };
+    explicit operator bool() const noexcept {
+        return Get() != nullptr;
+    };
+
+    // Comparisons take both the pointer and the tag into account
+    bool operator==(const TaggedIntrusivePtr& other) const noexcept {
+        return word_ == other.word_;
+    };
+    bool operator==(std::nullptr_t) const noexcept {
+        return Get() == nullptr;
+    };
+
+private:
+    TaggedWord<T> word_;
+};
+
+template <typename T>
+struct IsTriviallyRelocatable<TaggedIntrusivePtr<T>> : std::true_type {};
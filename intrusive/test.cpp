@@ -4,7 +4,9 @@
 
 #include "allocations_checker.h"
 
+#include <iterator>
 #include <string>
+#include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -397,3 +399,186 @@ TEST_CASE("Object pool") {
         REQUIRE(strs.NumInUse() == 1);
     }
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct CountingIncRef : public SimpleRefCounted<CountingIncRef> {
+    void IncRef() {
+        ++single_increments;
+        SimpleRefCounted<CountingIncRef>::IncRef();
+    }
+    void IncRef(size_t count) {
+        ++bulk_increments;
+        SimpleRefCounted<CountingIncRef>::IncRef(count);
+    }
+
+    int single_increments = 0;
+    int bulk_increments = 0;
+};
+
+TEST_CASE("ShareN") {
+    SECTION("One counter update") {
+        IntrusivePtr<CountingIncRef> p(new CountingIncRef);
+        std::vector<IntrusivePtr<CountingIncRef>> out(5);
+        p.ShareN(out.size(), out.begin());
+
+        REQUIRE(p.UseCount() == 6);
+        REQUIRE(p->single_increments == 1);
+        REQUIRE(p->bulk_increments == 1);
+        for (const auto& q : out) {
+            REQUIRE(q.Get() == p.Get());
+        }
+        out.clear();
+        REQUIRE(p.UseCount() == 1);
+    }
+
+    SECTION("Back inserter") {
+        IntrusivePtr<MyString> p(new MyString("broadcast"));
+        std::vector<IntrusivePtr<MyString>> out;
+        p.ShareN(3, std::back_inserter(out));
+
+        REQUIRE(out.size() == 3);
+        REQUIRE(p.UseCount() == 4);
+        REQUIRE(*out[2] == "broadcast");
+    }
+
+    SECTION("Empty") {
+        IntrusivePtr<MyString> p;
+        std::vector<IntrusivePtr<MyString>> out;
+        p.ShareN(2, std::back_inserter(out));
+
+        REQUIRE(out.size() == 2);
+        REQUIRE(!out[0]);
+    }
+
+    SECTION("Counter without bulk increment") {
+        ObjectPool<PoolableString> strs;
+        auto a = strs.Allocate("pooled");
+        std::vector<IntrusivePtr<PoolableString>> out;
+        a.ShareN(4, std::back_inserter(out));
+
+        REQUIRE(a.UseCount() == 5);
+        out.clear();
+        REQUIRE(a.UseCount() == 1);
+    }
+}
+
+TEST_CASE("Copying a RefCounted object") {
+    IntrusivePtr<MyInt> a(new MyInt(1));
+    IntrusivePtr<MyInt> b(new MyInt(2));
+    IntrusivePtr<MyInt> c = b;
+    *a = *b;
+
+    REQUIRE(a->value == 2);
+    REQUIRE(a.UseCount() == 1);
+    REQUIRE(b.UseCount() == 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Node : SimpleRefCounted<Node> {
+    enum Kind { kLeaf, kBranch };
+
+    explicit Node(Kind kind) : kind(kind) {
+    }
+    virtual ~Node() = default;
+
+    Kind kind;
+};
+
+struct Leaf : Node {
+    Leaf() : Node(kLeaf) {
+    }
+
+    static bool ClassOf(const Node* node) {
+        return node->kind == kLeaf;
+    }
+};
+
+struct Branch : Node {
+    Branch() : Node(kBranch) {
+    }
+
+    static bool ClassOf(const Node* node) {
+        return node->kind == kBranch;
+    }
+};
+
+TEST_CASE("Pointer casts") {
+    SECTION("Static") {
+        IntrusivePtr<Node> node = MakeIntrusive<Leaf>();
+        auto leaf = StaticPointerCast<Leaf>(node);
+        REQUIRE(node.UseCount() == 2);
+
+        auto moved = StaticPointerCast<Leaf>(std::move(node));
+        REQUIRE(!node);
+        REQUIRE(moved.UseCount() == 2);
+    }
+
+    SECTION("Dynamic") {
+        IntrusivePtr<Node> node = MakeIntrusive<Leaf>();
+
+        REQUIRE(!DynamicPointerCast<Branch>(node));
+        REQUIRE(!DynamicPointerCast<Branch>(std::move(node)));
+        REQUIRE(node.UseCount() == 1);
+
+        auto leaf = DynamicPointerCast<Leaf>(std::move(node));
+        REQUIRE(!node);
+        REQUIRE(leaf.UseCount() == 1);
+    }
+
+    SECTION("Fast dynamic") {
+        IntrusivePtr<Node> node = MakeIntrusive<Branch>();
+
+        REQUIRE(!FastDynamicPointerCast<Leaf>(node));
+        REQUIRE(FastDynamicPointerCast<Branch>(node).UseCount() == 2);
+
+        auto branch = FastDynamicPointerCast<Branch>(std::move(node));
+        REQUIRE(!node);
+        REQUIRE(branch.UseCount() == 1);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Counts the destructions instead of deleting, the sentinel is a static
+struct CountDestroy {
+    template <typename T>
+    static void Destroy(T*) {
+        ++T::destroyed;
+    }
+};
+
+struct Sentinel : SimpleRefCounted<Sentinel, CountDestroy> {
+    Sentinel() {
+        MakeImmortal();
+    }
+
+    static inline int destroyed = 0;
+};
+
+TEST_CASE("Immortal objects") {
+    SECTION("Static object") {
+        static Sentinel sentinel;
+        {
+            IntrusivePtr<Sentinel> a(&sentinel);
+            IntrusivePtr<Sentinel> b = a;
+            IntrusivePtr<Sentinel> c = std::move(b);
+            std::vector<IntrusivePtr<Sentinel>> copies;
+            a.ShareN(3, std::back_inserter(copies));
+
+            REQUIRE(sentinel.IsImmortal());
+            REQUIRE(c.Get() == &sentinel);
+        }
+        REQUIRE(Sentinel::destroyed == 0);
+        REQUIRE(sentinel.IsImmortal());
+    }
+
+    SECTION("Counting is not affected for other objects") {
+        auto mortal = MakeIntrusive<MyInt>(1);
+        auto copy = mortal;
+
+        REQUIRE(!mortal->IsImmortal());
+        REQUIRE(mortal.UseCount() == 2);
+    }
+}
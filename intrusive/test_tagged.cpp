@@ -0,0 +1,74 @@
+#include "tagged_intrusive.h"
+
+#include <catch.hpp>
+
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct alignas(16) TaggedNode : public SimpleRefCounted<TaggedNode> {
+    explicit TaggedNode(std::string name) : name{std::move(name)} {
+    }
+
+    std::string name;
+    TaggedIntrusivePtr<TaggedNode> next;
+};
+
+TEST_CASE("Tagged intrusive") {
+    SECTION("Sizeof") {
+        static_assert(sizeof(TaggedIntrusivePtr<TaggedNode>) == sizeof(void*));
+        static_assert(TaggedIntrusivePtr<TaggedNode>::TagBits() == 4);
+    }
+
+    SECTION("Copy shares the object and the tag") {
+        TaggedIntrusivePtr<TaggedNode> a(new TaggedNode{"a"}, 9);
+        TaggedIntrusivePtr<TaggedNode> b = a;
+
+        REQUIRE(a.UseCount() == 2);
+        REQUIRE(b.GetTag() == 9);
+        REQUIRE(b->name == "a");
+        REQUIRE(a == b);
+
+        b.SetTag(3);
+        REQUIRE(!(a == b));
+        REQUIRE(a.Get() == b.Get());
+    }
+
+    SECTION("Move") {
+        TaggedIntrusivePtr<TaggedNode> a(MakeIntrusive<TaggedNode>("a"), 1);
+        TaggedIntrusivePtr<TaggedNode> b(MakeIntrusive<TaggedNode>("b"), 2);
+        b = std::move(a);
+
+        REQUIRE(!a);
+        REQUIRE(a.GetTag() == 0);
+        REQUIRE(b.GetTag() == 1);
+        REQUIRE(b.UseCount() == 1);
+
+        TaggedIntrusivePtr<TaggedNode> c(std::move(b));
+        REQUIRE(c->name == "a");
+        REQUIRE(c.GetTag() == 1);
+        REQUIRE(b == nullptr);
+    }
+
+    SECTION("Assignment") {
+        TaggedIntrusivePtr<TaggedNode> a(new TaggedNode{"a"}, 1);
+        TaggedIntrusivePtr<TaggedNode> b(new TaggedNode{"b"}, 2);
+        TaggedIntrusivePtr<TaggedNode> c = b;
+        b = a;
+        a = a;
+
+        REQUIRE(a.UseCount() == 2);
+        REQUIRE(c.UseCount() == 1);
+        REQUIRE(b.GetTag() == 1);
+    }
+
+    SECTION("Chain") {
+        TaggedIntrusivePtr<TaggedNode> head(new TaggedNode{"head"}, 15);
+        head->next.Reset(new TaggedNode{"tail"});
+        head->next.SetTag(4);
+
+        REQUIRE(head->next->name == "tail");
+        REQUIRE(head->next.GetTag() == 4);
+        REQUIRE(head.GetTag() == 15);
+    }
+}
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <relative/relative.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>  // size_t, std::max_align_t
+#include <cstdint>  // uint64_t
+#include <new>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// Object heap in a memory-mapped file that survives restarts: reopening the file maps
+// the objects back instead of rebuilding them. Objects in the heap refer to each other with
+// `RelativePtr`-s and own each other with `MappedUniquePtr`-s, which stay valid wherever
+// the file is mapped; they must not hold raw pointers or memory outside the heap.
+// The way back into the graph is the root object.
+//
+// The header keeps a clean shutdown marker: it is cleared while the heap is open and set
+// by the destructor after flushing. A heap that was not closed cleanly may be half-written,
+// so reopening it starts from an empty heap (see `GetState`).
+// One process uses a heap at a time; the allocator is first-fit without coalescing.
+class MappedHeap {
+public:
+    enum class State {
+        kCreated,    // A new file
+        kRestored,   // Objects of a cleanly closed heap
+        kDiscarded,  // The heap was not closed cleanly, its contents were dropped
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    // Maps the heap in `path`, creating a file of `size` bytes if there is none or it is empty.
+    // The size of an existing heap is kept. Any other file is left as it is and
+    // `std::system_error` with `EINVAL` is thrown.
+    MappedHeap(const std::string& path, size_t size) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+        struct stat info {};
+        if (::fstat(fd_, &info) != 0) {
+            Fail("fstat");
+        }
+        bool exists = info.st_size != 0;
+        if (exists) {
+            size = static_cast<size_t>(info.st_size);
+            uint64_t magic = 0;
+            if (size < sizeof(Header) ||
+                ::pread(fd_, &magic, sizeof(magic), 0) != static_cast<ssize_t>(sizeof(magic)) ||
+                magic != kMagic) {
+                ::close(fd_);
+                throw std::system_error(EINVAL, std::generic_category(), "not a heap: " + path);
+            }
+        } else if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            Fail("ftruncate");
+        }
+        size_ = size;
+        void* base = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (base == MAP_FAILED) {
+            Fail("mmap");
+        }
+        base_ = static_cast<char*>(base);
+
+        Header* header = GetHeader();
+        if (!exists) {
+            Format();
+            state_ = State::kCreated;
+        } else if (header->clean == 0) {
+            Format();
+            state_ = State::kDiscarded;
+        } else {
+            state_ = State::kRestored;
+        }
+        GetHeader()->clean = 0;
+        Flush();
+        Registry().push_back(this);
+    }
+
+    MappedHeap(const MappedHeap&) = delete;
+    MappedHeap& operator=(const MappedHeap&) = delete;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Destructor
+
+    // Flushes the objects and marks the heap clean, they are not destroyed
+    ~MappedHeap() {
+        auto& registry = Registry();
+        registry.erase(std::find(registry.begin(), registry.end(), this));
+        Flush();
+        GetHeader()->clean = 1;
+        ::msync(base_, sizeof(Header), MS_SYNC);
+        ::munmap(base_, size_);
+        ::close(fd_);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Allocation
+
+    // Aligned to `std::max_align_t`. Throws `std::bad_alloc` if the heap is full.
+    void* Allocate(size_t size) {
+        size_t need = AlignUp(size);
+        Header* header = GetHeader();
+
+        uint64_t* link = &header->free_list;
+        while (*link != 0) {
+            Chunk* chunk = ChunkAt(*link);
+            if (chunk->size >= need) {
+                uint64_t offset = std::exchange(*link, chunk->next_free);
+                header->used += chunk->size;
+                return base_ + offset + sizeof(Chunk);
+            }
+            link = &chunk->next_free;
+        }
+
+        if (header->bump + sizeof(Chunk) + need > size_) {
+            throw std::bad_alloc();
+        }
+        uint64_t offset = header->bump;
+        header->bump += sizeof(Chunk) + need;
+        header->used += need;
+        ::new (base_ + offset) Chunk{need, 0};
+        return base_ + offset + sizeof(Chunk);
+    };
+    void Deallocate(void* ptr) noexcept {
+        uint64_t offset = static_cast<uint64_t>(static_cast<char*>(ptr) - base_) - sizeof(Chunk);
+        Header* header = GetHeader();
+        Chunk* chunk = ChunkAt(offset);
+        header->used -= chunk->size;
+        chunk->next_free = std::exchange(header->free_list, offset);
+    };
+
+    template <typename T, typename... Args>
+    T* New(Args&&... args) {
+        static_assert(alignof(T) <= alignof(std::max_align_t),
+                      "Over-aligned types are not supported");
+        void* memory = Allocate(sizeof(T));
+        try {
+            return ::new (memory) T(std::forward<Args>(args)...);
+        } catch (...) {
+            Deallocate(memory);
+            throw;
+        }
+    };
+    template <typename T>
+    void Delete(T* object) noexcept {
+        object->~T();
+        Deallocate(object);
+    };
+
+    // The heap that holds `ptr`, `nullptr` if it is not in a mapped heap
+    static MappedHeap* Containing(const void* ptr) noexcept {
+        for (MappedHeap* heap : Registry()) {
+            const char* address = static_cast<const char*>(ptr);
+            if (address >= heap->base_ && address < heap->base_ + heap->size_) {
+                return heap;
+            }
+        }
+        return nullptr;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Root object
+
+    // The caller keeps track of the root type, only its size is checked
+    template <typename T>
+    T* GetRoot() const noexcept {
+        const Header* header = GetHeader();
+        if (header->root_size != sizeof(T)) {
+            return nullptr;
+        }
+        return reinterpret_cast<T*>(header->root.Get());
+    };
+    template <typename T>
+    void SetRoot(T* root) noexcept {
+        Header* header = GetHeader();
+        header->root = reinterpret_cast<char*>(root);
+        header->root_size = root != nullptr ? sizeof(T) : 0;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    State GetState() const noexcept {
+        return state_;
+    };
+    size_t Size() const noexcept {
+        return size_;
+    };
+    // Bytes handed out by `Allocate` and not freed yet
+    size_t Used() const noexcept {
+        return GetHeader()->used;
+    };
+
+    // Writes the mapped pages to the file
+    void Flush() noexcept {
+        ::msync(base_, size_, MS_SYNC);
+    };
+
+private:
+    static constexpr uint64_t kMagic = 0x4d41'5048'4541'5031;  // "MAPHEAP1"
+
+    struct Header {
+        uint64_t magic;
+        uint64_t clean;
+        uint64_t bump;
+        uint64_t free_list;
+        uint64_t used;
+        uint64_t root_size;
+        RelativePtr<char> root;
+    };
+    struct alignas(std::max_align_t) Chunk {
+        uint64_t size;
+        uint64_t next_free;
+    };
+
+    static std::vector<MappedHeap*>& Registry() {
+        static std::vector<MappedHeap*> heaps;
+        return heaps;
+    }
+
+    static constexpr size_t AlignUp(size_t size) noexcept {
+        constexpr size_t kAlign = alignof(std::max_align_t);
+        return (size + kAlign - 1) / kAlign * kAlign;
+    }
+
+    [[noreturn]] void Fail(const char* what) {
+        int error = errno;
+        ::close(fd_);
+        throw std::system_error(error, std::generic_category(), what);
+    }
+
+    void Format() noexcept {
+        Header* header = ::new (base_) Header{};
+        header->magic = kMagic;
+        header->bump = AlignUp(sizeof(Header));
+    }
+
+    Header* GetHeader() const noexcept {
+        return std::launder(reinterpret_cast<Header*>(base_));
+    }
+    Chunk* ChunkAt(uint64_t offset) const noexcept {
+        return std::launder(reinterpret_cast<Chunk*>(base_ + offset));
+    }
+
+    int fd_ = -1;
+    size_t size_ = 0;
+    char* base_ = nullptr;
+    State state_ = State::kCreated;
+};
+
+// Deleter for objects made by `MappedHeap::New`. It is stateless, so owning pointers inside
+// the heap stay valid after a restart: the heap is found by the address of the object.
+struct MappedHeapDelete {
+    template <typename T>
+    void operator()(T* object) const noexcept {
+        Destroy(object);
+    }
+    // For `RefCounted` objects that live in a heap
+    template <typename T>
+    static void Destroy(T* object) noexcept {
+        MappedHeap::Containing(object)->Delete(object);
+    }
+};
+
+// Owning self-relative pointer between objects of a `MappedHeap`
+template <typename T>
+using MappedUniquePtr = RelativeUniquePtr<T, MappedHeapDelete>;
+
+template <typename T, typename... Args>
+MappedUniquePtr<T> MakeMappedUnique(MappedHeap& heap, Args&&... args) {
+    return MappedUniquePtr<T>(heap.New<T>(std::forward<Args>(args)...));
+};
@@ -0,0 +1,149 @@
+#include "mapped_heap.h"
+
+#include <catch.hpp>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Entry {
+    Entry(int key, int value) : key(key), value(value) {
+    }
+
+    int key;
+    int value;
+    MappedUniquePtr<Entry> next;
+};
+
+struct Index {
+    MappedUniquePtr<Entry> head;
+    RelativePtr<Entry> largest;
+    int size = 0;
+};
+
+class TempFile {
+public:
+    TempFile() {
+        char name[] = "/tmp/mapped-heap-XXXXXX";
+        int fd = ::mkstemp(name);
+        ::close(fd);
+        path_ = name;
+    }
+    ~TempFile() {
+        ::unlink(path_.c_str());
+    }
+
+    const std::string& Path() const {
+        return path_;
+    }
+
+private:
+    std::string path_;
+};
+
+void WriteFile(const std::string& path, const std::string& data) {
+    std::ofstream(path, std::ios::binary) << data;
+}
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void FillIndex(MappedHeap& heap, int count) {
+    Index* index = heap.New<Index>();
+    for (int key = 0; key < count; ++key) {
+        auto entry = MakeMappedUnique<Entry>(heap, key, key * key);
+        entry->next = std::move(index->head);
+        index->head = std::move(entry);
+        ++index->size;
+    }
+    index->largest = index->head.Get();
+    heap.SetRoot(index);
+}
+
+TEST_CASE("MappedHeap") {
+    TempFile file;
+
+    SECTION("Objects survive a restart") {
+        {
+            MappedHeap heap(file.Path(), 1 << 20);
+            REQUIRE(heap.GetState() == MappedHeap::State::kCreated);
+            REQUIRE(heap.GetRoot<Index>() == nullptr);
+            FillIndex(heap, 100);
+        }
+
+        MappedHeap heap(file.Path(), 1 << 20);
+        REQUIRE(heap.GetState() == MappedHeap::State::kRestored);
+
+        Index* index = heap.GetRoot<Index>();
+        REQUIRE(index != nullptr);
+        REQUIRE(index->size == 100);
+        REQUIRE(index->largest->key == 99);
+
+        int sum = 0;
+        for (Entry* entry = index->head.Get(); entry != nullptr; entry = entry->next.Get()) {
+            REQUIRE(entry->value == entry->key * entry->key);
+            sum += entry->key;
+        }
+        REQUIRE(sum == 99 * 100 / 2);
+    }
+
+    SECTION("Owning pointers free their objects") {
+        MappedHeap heap(file.Path(), 1 << 20);
+        FillIndex(heap, 10);
+        size_t used = heap.Used();
+
+        Index* index = heap.GetRoot<Index>();
+        index->head = std::move(index->head->next);
+        REQUIRE(heap.Used() < used);
+
+        heap.SetRoot<Index>(nullptr);
+        heap.Delete(index);
+        REQUIRE(heap.Used() == 0);
+        REQUIRE(MappedHeap::Containing(&heap) == nullptr);
+    }
+
+    SECTION("Full heap") {
+        MappedHeap heap(file.Path(), 4096);
+        REQUIRE_THROWS_AS(heap.Allocate(8192), std::bad_alloc);
+    }
+
+    SECTION("Other files are not touched") {
+        for (const std::string& data : {std::string(4096, 'x'), std::string("short")}) {
+            WriteFile(file.Path(), data);
+            try {
+                MappedHeap heap(file.Path(), 1 << 20);
+                FAIL("Opened a file that is not a heap");
+            } catch (const std::system_error& error) {
+                REQUIRE(error.code().value() == EINVAL);
+            }
+            REQUIRE(ReadFile(file.Path()) == data);
+        }
+    }
+
+    SECTION("A heap that was not closed is discarded") {
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            auto* heap = new MappedHeap(file.Path(), 1 << 20);
+            FillIndex(*heap, 10);
+            ::_exit(0);
+        }
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        REQUIRE(WIFEXITED(status));
+
+        MappedHeap heap(file.Path(), 1 << 20);
+        REQUIRE(heap.GetState() == MappedHeap::State::kDiscarded);
+        REQUIRE(heap.GetRoot<Index>() == nullptr);
+        REQUIRE(heap.Used() == 0);
+    }
+}
@@ -0,0 +1,349 @@
+#pragma once
+
+#include <intrusive/intrusive.h>
+
+#include <bit>
+#include <cassert>
+#include <cstddef>  // size_t
+#include <cstdint>  // uint32_t
+#include <functional>
+#include <utility>
+#include <vector>
+
+template <typename K, typename V, typename Hash, typename Equal>
+class PersistentMap;
+
+template <typename K, typename V, typename Hash, typename Equal>
+class TransientMap;
+
+// Hash array mapped trie shared by `PersistentMap` and `TransientMap`.
+// Each level consumes `kBits` of the hash; a node keeps two bitmaps of its occupied slots,
+// one for inline key-value pairs and one for child nodes, and stores both densely.
+// Keys whose hashes are equal in all bits end up together in a collision node at the bottom.
+// An update copies the nodes on the path to its key; with `in_place`, nodes referenced only
+// by this trie are modified instead.
+template <typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+class HashTrie {
+public:
+    static constexpr size_t kBits = 5;
+    static constexpr size_t kHashBits = sizeof(size_t) * 8;
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    const V* Find(const K& key) const {
+        size_t hash = Hash()(key);
+        const Node* node = root_.Get();
+        for (size_t shift = 0; node != nullptr; shift += kBits) {
+            if (shift >= kHashBits) {
+                return FindInCollision(node, key);
+            }
+            uint32_t bit = BitOf(hash, shift);
+            if (node->datamap & bit) {
+                const auto& entry = node->entries[IndexOf(node->datamap, bit)];
+                return Equal()(entry.first, key) ? &entry.second : nullptr;
+            }
+            if (!(node->nodemap & bit)) {
+                return nullptr;
+            }
+            node = node->children[IndexOf(node->nodemap, bit)].Get();
+        }
+        return nullptr;
+    }
+
+    void Set(K key, V value, bool in_place) {
+        bool added = false;
+        root_ = SetIn(root_, 0, Hash()(key), std::move(key), std::move(value), in_place, added);
+        size_ += added;
+    }
+
+    bool Erase(const K& key, bool in_place) {
+        if (Find(key) == nullptr) {
+            return false;
+        }
+        root_ = EraseIn(root_, 0, Hash()(key), key, in_place);
+        --size_;
+        return true;
+    }
+
+    template <typename F>
+    void ForEach(F&& visit) const {
+        if (root_) {
+            Visit(root_.Get(), visit);
+        }
+    }
+
+private:
+    struct Node : SimpleRefCounted<Node> {
+        uint32_t datamap = 0;
+        uint32_t nodemap = 0;
+        // Collision nodes keep all of their pairs here and leave both bitmaps empty
+        std::vector<std::pair<K, V>> entries;
+        std::vector<IntrusivePtr<Node>> children;
+    };
+
+    static uint32_t BitOf(size_t hash, size_t shift) noexcept {
+        return uint32_t{1} << ((hash >> shift) & ((size_t{1} << kBits) - 1));
+    }
+    static size_t IndexOf(uint32_t bitmap, uint32_t bit) noexcept {
+        return std::popcount(bitmap & (bit - 1));
+    }
+
+    static const V* FindInCollision(const Node* node, const K& key) {
+        for (const auto& entry : node->entries) {
+            if (Equal()(entry.first, key)) {
+                return &entry.second;
+            }
+        }
+        return nullptr;
+    }
+
+    // A node that may be modified: `node` itself if nothing else refers to it, otherwise a copy.
+    // Parents are always made editable before their children, so a count of 1 means that
+    // no other version can reach the node.
+    static IntrusivePtr<Node> Edit(const IntrusivePtr<Node>& node, bool in_place) {
+        if (!node) {
+            return MakeIntrusive<Node>();
+        }
+        if (in_place && node->RefCount() == 1) {
+            return node;
+        }
+        return MakeIntrusive<Node>(*node);
+    }
+
+    static IntrusivePtr<Node> SetIn(const IntrusivePtr<Node>& node, size_t shift, size_t hash,
+                                    K&& key, V&& value, bool in_place, bool& added) {
+        IntrusivePtr<Node> result = Edit(node, in_place);
+        if (shift >= kHashBits) {
+            for (auto& entry : result->entries) {
+                if (Equal()(entry.first, key)) {
+                    entry.second = std::move(value);
+                    return result;
+                }
+            }
+            result->entries.emplace_back(std::move(key), std::move(value));
+            added = true;
+            return result;
+        }
+        uint32_t bit = BitOf(hash, shift);
+        if (result->datamap & bit) {
+            size_t index = IndexOf(result->datamap, bit);
+            auto& entry = result->entries[index];
+            if (Equal()(entry.first, key)) {
+                entry.second = std::move(value);
+                return result;
+            }
+            // Two keys share the slot, push both one level down
+            size_t entry_hash = Hash()(entry.first);
+            IntrusivePtr<Node> child = Merge(std::move(entry), entry_hash,
+                                             {std::move(key), std::move(value)}, hash,
+                                             shift + kBits);
+            result->entries.erase(result->entries.begin() + index);
+            result->datamap &= ~bit;
+            result->children.insert(result->children.begin() + IndexOf(result->nodemap, bit),
+                                    std::move(child));
+            result->nodemap |= bit;
+            added = true;
+            return result;
+        }
+        if (result->nodemap & bit) {
+            IntrusivePtr<Node>& child = result->children[IndexOf(result->nodemap, bit)];
+            child = SetIn(child, shift + kBits, hash, std::move(key), std::move(value), in_place,
+                          added);
+            return result;
+        }
+        result->entries.emplace(result->entries.begin() + IndexOf(result->datamap, bit),
+                                std::move(key), std::move(value));
+        result->datamap |= bit;
+        added = true;
+        return result;
+    }
+
+    static IntrusivePtr<Node> Merge(std::pair<K, V>&& first, size_t first_hash,
+                                    std::pair<K, V>&& second, size_t second_hash, size_t shift) {
+        IntrusivePtr<Node> node = MakeIntrusive<Node>();
+        if (shift >= kHashBits) {
+            node->entries.push_back(std::move(first));
+            node->entries.push_back(std::move(second));
+            return node;
+        }
+        uint32_t first_bit = BitOf(first_hash, shift);
+        uint32_t second_bit = BitOf(second_hash, shift);
+        if (first_bit == second_bit) {
+            node->children.push_back(Merge(std::move(first), first_hash, std::move(second),
+                                           second_hash, shift + kBits));
+            node->nodemap = first_bit;
+            return node;
+        }
+        if (first_bit > second_bit) {
+            std::swap(first, second);
+        }
+        node->entries.push_back(std::move(first));
+        node->entries.push_back(std::move(second));
+        node->datamap = first_bit | second_bit;
+        return node;
+    }
+
+    // Removes a key that is known to be present. Returns null if the node becomes empty.
+    static IntrusivePtr<Node> EraseIn(const IntrusivePtr<Node>& node, size_t shift, size_t hash,
+                                      const K& key, bool in_place) {
+        IntrusivePtr<Node> result = Edit(node, in_place);
+        if (shift >= kHashBits) {
+            for (size_t i = 0; i < result->entries.size(); ++i) {
+                if (Equal()(result->entries[i].first, key)) {
+                    result->entries.erase(result->entries.begin() + i);
+                    break;
+                }
+            }
+            return result->entries.empty() ? nullptr : result;
+        }
+        uint32_t bit = BitOf(hash, shift);
+        if (result->datamap & bit) {
+            result->entries.erase(result->entries.begin() + IndexOf(result->datamap, bit));
+            result->datamap &= ~bit;
+        } else {
+            size_t index = IndexOf(result->nodemap, bit);
+            IntrusivePtr<Node> child = EraseIn(result->children[index], shift + kBits, hash, key,
+                                               in_place);
+            if (child && (!child->children.empty() || child->entries.size() > 1)) {
+                result->children[index] = std::move(child);
+                return result;
+            }
+            result->children.erase(result->children.begin() + index);
+            result->nodemap &= ~bit;
+            if (child) {
+                // A single pair left below is pulled up into this node
+                result->entries.insert(result->entries.begin() + IndexOf(result->datamap, bit),
+                                       std::move(child->entries.front()));
+                result->datamap |= bit;
+            }
+        }
+        if (result->entries.empty() && result->children.empty()) {
+            return nullptr;
+        }
+        return result;
+    }
+
+    template <typename F>
+    static void Visit(const Node* node, F& visit) {
+        for (const auto& entry : node->entries) {
+            visit(entry.first, entry.second);
+        }
+        for (const auto& child : node->children) {
+            Visit(child.Get(), visit);
+        }
+    }
+
+    IntrusivePtr<Node> root_;
+    size_t size_ = 0;
+};
+
+// Immutable hash map: updates return a new version that shares all untouched nodes with this one.
+// Copying is O(1), `Set` and `Erase` copy O(log32 n) nodes.
+template <typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+class PersistentMap {
+public:
+    PersistentMap() = default;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Updates
+
+    PersistentMap Set(K key, V value) const {
+        PersistentMap result = *this;
+        result.trie_.Set(std::move(key), std::move(value), false);
+        return result;
+    }
+    PersistentMap Erase(const K& key) const {
+        PersistentMap result = *this;
+        result.trie_.Erase(key, false);
+        return result;
+    }
+
+    // Mutable copy for a batch of updates
+    TransientMap<K, V, Hash, Equal> Transient() const {
+        return TransientMap<K, V, Hash, Equal>(trie_);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    // Value of `key`, or `nullptr`
+    const V* Find(const K& key) const {
+        return trie_.Find(key);
+    }
+    bool Contains(const K& key) const {
+        return trie_.Find(key) != nullptr;
+    }
+    size_t Size() const noexcept {
+        return trie_.Size();
+    }
+    bool Empty() const noexcept {
+        return trie_.Size() == 0;
+    }
+    // Calls `visit(key, value)` for every pair in unspecified order
+    template <typename F>
+    void ForEach(F&& visit) const {
+        trie_.ForEach(visit);
+    }
+
+private:
+    friend class TransientMap<K, V, Hash, Equal>;
+
+    explicit PersistentMap(HashTrie<K, V, Hash, Equal> trie) : trie_(std::move(trie)) {
+    }
+
+    HashTrie<K, V, Hash, Equal> trie_;
+};
+
+// Batch-update mode of `PersistentMap`: updates modify the nodes this map owns alone
+// and copy only the ones still shared with persistent versions, each of them at most once.
+template <typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+class TransientMap {
+public:
+    TransientMap() = default;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Modifiers
+
+    void Set(K key, V value) {
+        trie_.Set(std::move(key), std::move(value), true);
+    }
+    bool Erase(const K& key) {
+        return trie_.Erase(key, true);
+    }
+
+    // Freezes the contents into a persistent version, this map is left empty
+    PersistentMap<K, V, Hash, Equal> Persistent() {
+        return PersistentMap<K, V, Hash, Equal>(
+            std::exchange(trie_, HashTrie<K, V, Hash, Equal>()));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    const V* Find(const K& key) const {
+        return trie_.Find(key);
+    }
+    bool Contains(const K& key) const {
+        return trie_.Find(key) != nullptr;
+    }
+    size_t Size() const noexcept {
+        return trie_.Size();
+    }
+    bool Empty() const noexcept {
+        return trie_.Size() == 0;
+    }
+    template <typename F>
+    void ForEach(F&& visit) const {
+        trie_.ForEach(visit);
+    }
+
+private:
+    friend class PersistentMap<K, V, Hash, Equal>;
+
+    explicit TransientMap(HashTrie<K, V, Hash, Equal> trie) : trie_(std::move(trie)) {
+    }
+
+    HashTrie<K, V, Hash, Equal> trie_;
+};
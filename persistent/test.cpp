@@ -0,0 +1,113 @@
+#include "vector.h"
+
+#include <catch.hpp>
+
+#include "allocations_checker.h"
+
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("PersistentVector") {
+    SECTION("Push back and index") {
+        PersistentVector<int> vector;
+        for (int i = 0; i < 5000; ++i) {
+            vector = vector.PushBack(i);
+        }
+
+        REQUIRE(vector.Size() == 5000);
+        for (int i = 0; i < 5000; ++i) {
+            REQUIRE(vector[i] == i);
+        }
+    }
+
+    SECTION("Old versions are unchanged") {
+        std::vector<PersistentVector<int>> versions(1);
+        for (int i = 0; i < 100; ++i) {
+            versions.push_back(versions.back().PushBack(i));
+        }
+        auto changed = versions.back().Set(50, -1);
+
+        for (size_t size = 0; size < versions.size(); ++size) {
+            REQUIRE(versions[size].Size() == size);
+            for (size_t i = 0; i < size; ++i) {
+                REQUIRE(versions[size][i] == static_cast<int>(i));
+            }
+        }
+        REQUIRE(changed[50] == -1);
+        REQUIRE(changed[49] == 49);
+    }
+
+    SECTION("Pop back") {
+        PersistentVector<std::string> vector;
+        for (int i = 0; i < 1100; ++i) {
+            vector = vector.PushBack(std::to_string(i));
+        }
+        auto full = vector;
+        while (!vector.Empty()) {
+            vector = vector.PopBack();
+            if (!vector.Empty()) {
+                REQUIRE(vector[vector.Size() - 1] == std::to_string(vector.Size() - 1));
+            }
+        }
+
+        REQUIRE(full.Size() == 1100);
+        REQUIRE(full[1099] == "1099");
+        vector = vector.PushBack("again");
+        REQUIRE(vector[0] == "again");
+    }
+
+    SECTION("Updates copy only the path") {
+        PersistentVector<int> vector;
+        for (int i = 0; i < 32 * 32 * 2; ++i) {
+            vector = vector.PushBack(i);
+        }
+        // Root, one branch and one leaf with its values
+        EXPECT_ALLOCATIONS(vector.Set(1000, 0), 4);
+    }
+}
+
+TEST_CASE("TransientVector") {
+    SECTION("Batch of updates") {
+        PersistentVector<int> base;
+        for (int i = 0; i < 100; ++i) {
+            base = base.PushBack(i);
+        }
+
+        auto transient = base.Transient();
+        for (int i = 0; i < 100; ++i) {
+            transient.Set(i, i * 2);
+        }
+        transient.PushBack(200);
+        transient.PopBack();
+        transient.PushBack(300);
+        auto result = transient.Persistent();
+
+        REQUIRE(transient.Empty());
+        REQUIRE(result.Size() == 101);
+        REQUIRE(result[99] == 198);
+        REQUIRE(result[100] == 300);
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(base[i] == i);
+        }
+    }
+
+    SECTION("Owned nodes are modified in place") {
+        TransientVector<int> transient;
+        for (int i = 0; i < 1000; ++i) {
+            transient.PushBack(i);
+        }
+        EXPECT_ZERO_ALLOCATIONS(transient.Set(500, -1));
+
+        auto frozen = transient.Persistent();
+        auto again = frozen.Transient();
+        // Shared with `frozen` now: the first update copies the path, the second one reuses it
+        again.Set(10, 1);
+        EXPECT_ZERO_ALLOCATIONS(again.Set(11, 1));
+
+        REQUIRE(frozen[10] == 10);
+        REQUIRE(frozen[500] == -1);
+        REQUIRE(again[10] == 1);
+    }
+}
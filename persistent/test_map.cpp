@@ -0,0 +1,125 @@
+#include "map.h"
+
+#include <catch.hpp>
+
+#include "allocations_checker.h"
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Puts every key into one of a few buckets to force deep paths and collision nodes
+struct PoorHash {
+    size_t operator()(int key) const {
+        return static_cast<size_t>(key % 4);
+    }
+};
+
+TEST_CASE("PersistentMap") {
+    SECTION("Set and find") {
+        PersistentMap<std::string, int> map;
+        map = map.Set("one", 1).Set("two", 2).Set("three", 3);
+
+        REQUIRE(map.Size() == 3);
+        REQUIRE(*map.Find("two") == 2);
+        REQUIRE(map.Find("four") == nullptr);
+
+        map = map.Set("two", 22);
+        REQUIRE(map.Size() == 3);
+        REQUIRE(*map.Find("two") == 22);
+    }
+
+    SECTION("Old versions are unchanged") {
+        PersistentMap<int, int> empty;
+        auto one = empty.Set(1, 1);
+        auto two = one.Set(2, 2);
+        auto erased = two.Erase(1);
+
+        REQUIRE(empty.Empty());
+        REQUIRE(one.Size() == 1);
+        REQUIRE(two.Size() == 2);
+        REQUIRE(*two.Find(1) == 1);
+        REQUIRE(erased.Size() == 1);
+        REQUIRE_FALSE(erased.Contains(1));
+        REQUIRE(erased.Erase(1).Size() == 1);
+    }
+
+    SECTION("Collisions") {
+        PersistentMap<int, int, PoorHash> map;
+        for (int i = 0; i < 40; ++i) {
+            map = map.Set(i, i * 10);
+        }
+        REQUIRE(map.Size() == 40);
+        for (int i = 0; i < 40; ++i) {
+            REQUIRE(*map.Find(i) == i * 10);
+        }
+        for (int i = 0; i < 40; i += 2) {
+            map = map.Erase(i);
+        }
+        REQUIRE(map.Size() == 20);
+        for (int i = 0; i < 40; ++i) {
+            REQUIRE(map.Contains(i) == (i % 2 == 1));
+        }
+    }
+
+    SECTION("Matches std::map") {
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> keys(0, 2000);
+        std::map<int, int> expected;
+        PersistentMap<int, int> map;
+        for (int i = 0; i < 10000; ++i) {
+            int key = keys(gen);
+            if (gen() % 3 == 0) {
+                expected.erase(key);
+                map = map.Erase(key);
+            } else {
+                expected[key] = i;
+                map = map.Set(key, i);
+            }
+        }
+
+        REQUIRE(map.Size() == expected.size());
+        std::map<int, int> visited;
+        map.ForEach([&visited](int key, int value) { visited[key] = value; });
+        REQUIRE(visited == expected);
+    }
+}
+
+TEST_CASE("TransientMap") {
+    SECTION("Batch of updates") {
+        PersistentMap<int, std::string> base = PersistentMap<int, std::string>().Set(1, "one");
+
+        auto transient = base.Transient();
+        for (int i = 0; i < 1000; ++i) {
+            transient.Set(i, std::to_string(i));
+        }
+        REQUIRE(transient.Erase(500));
+        REQUIRE_FALSE(transient.Erase(500));
+        auto result = transient.Persistent();
+
+        REQUIRE(transient.Empty());
+        REQUIRE(result.Size() == 999);
+        REQUIRE(*result.Find(1) == "1");
+        REQUIRE(*base.Find(1) == "one");
+        REQUIRE(base.Size() == 1);
+    }
+
+    SECTION("Owned nodes are modified in place") {
+        TransientMap<int, int> transient;
+        for (int i = 0; i < 1000; ++i) {
+            transient.Set(i, i);
+        }
+        EXPECT_ZERO_ALLOCATIONS(transient.Set(500, -1));
+
+        auto frozen = transient.Persistent();
+        auto again = frozen.Transient();
+        again.Set(500, 0);
+        EXPECT_ZERO_ALLOCATIONS(again.Set(500, 1));
+
+        REQUIRE(*frozen.Find(500) == -1);
+        REQUIRE(*again.Find(500) == 1);
+    }
+}
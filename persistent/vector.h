@@ -0,0 +1,247 @@
+#pragma once
+
+#include <intrusive/intrusive.h>
+
+#include <array>
+#include <cassert>
+#include <cstddef>  // size_t
+#include <utility>
+#include <vector>
+
+template <typename T>
+class PersistentVector;
+
+template <typename T>
+class TransientVector;
+
+// Bit-partitioned trie shared by `PersistentVector` and `TransientVector`.
+// Index bits are consumed `kBits` at a time from the top, leaves hold up to `kWidth` values.
+// An update copies the nodes on the path to its leaf, O(log32 n) of them; with `in_place`,
+// nodes referenced only by this trie are modified instead.
+template <typename T>
+class VectorTrie {
+public:
+    static constexpr size_t kBits = 5;
+    static constexpr size_t kWidth = size_t{1} << kBits;
+    static constexpr size_t kMask = kWidth - 1;
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    const T& Get(size_t index) const noexcept {
+        assert(index < size_);
+        const Node* node = root_.Get();
+        for (size_t level = shift_; level > 0; level -= kBits) {
+            node = static_cast<const Branch*>(node)->children[(index >> level) & kMask].Get();
+        }
+        return static_cast<const Leaf*>(node)->values[index & kMask];
+    }
+
+    void Set(size_t index, T value, bool in_place) {
+        assert(index < size_);
+        root_ = SetIn(root_, shift_, index, std::move(value), in_place);
+    }
+
+    void PushBack(T value, bool in_place) {
+        if (root_ && size_ == (size_t{1} << (shift_ + kBits))) {
+            // The trie is full, grow a level on top
+            IntrusivePtr<Branch> branch = MakeIntrusive<Branch>();
+            branch->children[0] = std::move(root_);
+            root_ = std::move(branch);
+            shift_ += kBits;
+        }
+        root_ = PushIn(root_, shift_, size_, std::move(value), in_place);
+        ++size_;
+    }
+
+    void PopBack(bool in_place) {
+        assert(size_ > 0);
+        --size_;
+        root_ = PopIn(root_, shift_, size_, in_place);
+        while (root_ && shift_ > 0 && !static_cast<Branch*>(root_.Get())->children[1]) {
+            IntrusivePtr<Node> child = static_cast<Branch*>(root_.Get())->children[0];
+            root_ = std::move(child);
+            shift_ -= kBits;
+        }
+        if (!root_) {
+            shift_ = 0;
+        }
+    }
+
+private:
+    struct Node : SimpleRefCounted<Node> {
+        virtual ~Node() = default;
+    };
+    struct Branch : Node {
+        std::array<IntrusivePtr<Node>, kWidth> children;
+    };
+    struct Leaf : Node {
+        std::vector<T> values;
+    };
+
+    // A node that may be modified: `node` itself if nothing else refers to it, otherwise a copy.
+    // Parents are always made editable before their children, so a count of 1 means that
+    // no other version can reach the node.
+    template <typename N>
+    static IntrusivePtr<N> Edit(const IntrusivePtr<Node>& node, bool in_place) {
+        if (!node) {
+            return MakeIntrusive<N>();
+        }
+        N* typed = static_cast<N*>(node.Get());
+        if (in_place && typed->RefCount() == 1) {
+            return IntrusivePtr<N>(typed);
+        }
+        return MakeIntrusive<N>(*typed);
+    }
+
+    static IntrusivePtr<Node> SetIn(const IntrusivePtr<Node>& node, size_t level, size_t index,
+                                    T&& value, bool in_place) {
+        if (level == 0) {
+            IntrusivePtr<Leaf> leaf = Edit<Leaf>(node, in_place);
+            leaf->values[index & kMask] = std::move(value);
+            return leaf;
+        }
+        IntrusivePtr<Branch> branch = Edit<Branch>(node, in_place);
+        IntrusivePtr<Node>& child = branch->children[(index >> level) & kMask];
+        child = SetIn(child, level - kBits, index, std::move(value), in_place);
+        return branch;
+    }
+
+    static IntrusivePtr<Node> PushIn(const IntrusivePtr<Node>& node, size_t level, size_t index,
+                                     T&& value, bool in_place) {
+        if (level == 0) {
+            IntrusivePtr<Leaf> leaf = Edit<Leaf>(node, in_place);
+            if (leaf->values.empty()) {
+                leaf->values.reserve(kWidth);
+            }
+            leaf->values.push_back(std::move(value));
+            return leaf;
+        }
+        IntrusivePtr<Branch> branch = Edit<Branch>(node, in_place);
+        IntrusivePtr<Node>& child = branch->children[(index >> level) & kMask];
+        child = PushIn(child, level - kBits, index, std::move(value), in_place);
+        return branch;
+    }
+
+    // Removes the element at `index`, the last one. Returns null if the subtree becomes empty.
+    static IntrusivePtr<Node> PopIn(const IntrusivePtr<Node>& node, size_t level, size_t index,
+                                    bool in_place) {
+        if ((index & ((size_t{1} << (level + kBits)) - 1)) == 0) {
+            return nullptr;
+        }
+        if (level == 0) {
+            IntrusivePtr<Leaf> leaf = Edit<Leaf>(node, in_place);
+            leaf->values.pop_back();
+            return leaf;
+        }
+        IntrusivePtr<Branch> branch = Edit<Branch>(node, in_place);
+        IntrusivePtr<Node>& child = branch->children[(index >> level) & kMask];
+        child = PopIn(child, level - kBits, index, in_place);
+        return branch;
+    }
+
+    IntrusivePtr<Node> root_;
+    size_t size_ = 0;
+    size_t shift_ = 0;
+};
+
+// Immutable vector: updates return a new version that shares all untouched nodes with this one.
+// Copying is O(1), `Set`, `PushBack` and `PopBack` copy O(log32 n) nodes.
+template <typename T>
+class PersistentVector {
+public:
+    PersistentVector() = default;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Updates
+
+    PersistentVector Set(size_t index, T value) const {
+        PersistentVector result = *this;
+        result.trie_.Set(index, std::move(value), false);
+        return result;
+    }
+    PersistentVector PushBack(T value) const {
+        PersistentVector result = *this;
+        result.trie_.PushBack(std::move(value), false);
+        return result;
+    }
+    PersistentVector PopBack() const {
+        PersistentVector result = *this;
+        result.trie_.PopBack(false);
+        return result;
+    }
+
+    // Mutable copy for a batch of updates
+    TransientVector<T> Transient() const {
+        return TransientVector<T>(trie_);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    const T& operator[](size_t index) const noexcept {
+        return trie_.Get(index);
+    }
+    size_t Size() const noexcept {
+        return trie_.Size();
+    }
+    bool Empty() const noexcept {
+        return trie_.Size() == 0;
+    }
+
+private:
+    friend class TransientVector<T>;
+
+    explicit PersistentVector(VectorTrie<T> trie) : trie_(std::move(trie)) {
+    }
+
+    VectorTrie<T> trie_;
+};
+
+// Batch-update mode of `PersistentVector`: updates modify the nodes this vector owns alone
+// and copy only the ones still shared with persistent versions, each of them at most once.
+template <typename T>
+class TransientVector {
+public:
+    TransientVector() = default;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Modifiers
+
+    void Set(size_t index, T value) {
+        trie_.Set(index, std::move(value), true);
+    }
+    void PushBack(T value) {
+        trie_.PushBack(std::move(value), true);
+    }
+    void PopBack() {
+        trie_.PopBack(true);
+    }
+
+    // Freezes the contents into a persistent version, this vector is left empty
+    PersistentVector<T> Persistent() {
+        return PersistentVector<T>(std::exchange(trie_, VectorTrie<T>()));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    const T& operator[](size_t index) const noexcept {
+        return trie_.Get(index);
+    }
+    size_t Size() const noexcept {
+        return trie_.Size();
+    }
+    bool Empty() const noexcept {
+        return trie_.Size() == 0;
+    }
+
+private:
+    friend class PersistentVector<T>;
+
+    explicit TransientVector(VectorTrie<T> trie) : trie_(std::move(trie)) {
+    }
+
+    VectorTrie<T> trie_;
+};
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <unique/unique.h>
+
+#include <cassert>
+#include <cstddef>  // std::nullptr_t
+#include <cstdint>  // int32_t, int64_t, uintptr_t
+#include <limits>
+#include <utility>
+
+// Non-owning pointer that stores the distance from its own address to the pointee.
+// A block of memory holding both pointers and their targets stays valid after it is copied
+// with `memcpy` or mapped at another address.
+// Copying a `RelativePtr` itself recomputes the offset, so the copy points to the same object.
+// Offset 1 is the null value: an object starting one byte after the pointer would overlap it.
+template <typename T, typename Offset = int64_t>
+class RelativePtr {
+public:
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    RelativePtr() noexcept = default;
+    RelativePtr(std::nullptr_t) noexcept {
+    }
+    RelativePtr(T* ptr) noexcept {
+        Set(ptr);
+    };
+
+    RelativePtr(const RelativePtr& other) noexcept {
+        Set(other.Get());
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // `operator=`-s
+
+    RelativePtr& operator=(const RelativePtr& other) noexcept {
+        Set(other.Get());
+        return *this;
+    };
+    RelativePtr& operator=(T* ptr) noexcept {
+        Set(ptr);
+        return *this;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Modifiers
+
+    void Reset(T* ptr = nullptr) noexcept {
+        Set(ptr);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    T* Get() const noexcept {
+        if (offset_ == kNull) {
+            return nullptr;
+        }
+        return reinterpret_cast<T*>(Self() + static_cast<std::uintptr_t>(offset_));
+    };
+    Offset GetOffset() const noexcept {
+        return offset_;
+    };
+    T& operator*() const noexcept {
+        return *Get();
+    };
+    T* operator->() const noexcept {
+        return Get();
+    };
+    explicit operator bool() const noexcept {
+        return offset_ != kNull;
+    };
+
+private:
+    static constexpr Offset kNull = 1;
+
+    // The pointee is outside of this object, so the distance is taken between addresses
+    // rather than by pointer arithmetic
+    std::uintptr_t Self() const noexcept {
+        return reinterpret_cast<std::uintptr_t>(this);
+    }
+
+    void Set(T* ptr) noexcept {
+        if (ptr == nullptr) {
+            offset_ = kNull;
+            return;
+        }
+        auto diff = static_cast<std::ptrdiff_t>(reinterpret_cast<std::uintptr_t>(ptr) - Self());
+        assert(diff >= std::numeric_limits<Offset>::min());
+        assert(diff <= std::numeric_limits<Offset>::max());
+        offset_ = static_cast<Offset>(diff);
+    }
+
+    Offset offset_ = kNull;
+};
+
+template <typename T, typename U, typename Offset>
+inline bool operator==(const RelativePtr<T, Offset>& left, const RelativePtr<U, Offset>& right) {
+    return left.Get() == right.Get();
+};
+
+// `UniquePtr` over a `RelativePtr`: owns the pointee, but the stored value is an offset.
+// Use a 32-bit `Offset` for structures that fit in 2GB, e.g. an index in a mapped file.
+template <typename T, typename Deleter = Slug<T>, typename Offset = int64_t>
+class RelativeUniquePtr {
+public:
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    RelativeUniquePtr() noexcept = default;
+    explicit RelativeUniquePtr(T* ptr) noexcept {
+        pair_.GetFirst() = ptr;
+    };
+    RelativeUniquePtr(T* ptr, Deleter deleter) noexcept {
+        pair_.GetFirst() = ptr;
+        pair_.GetSecond() = std::forward<Deleter>(deleter);
+    };
+
+    RelativeUniquePtr(RelativeUniquePtr&& other) noexcept {
+        this->Swap(other);
+        other.Reset();
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // `operator=`-s
+
+    RelativeUniquePtr& operator=(RelativeUniquePtr&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        this->Swap(other);
+        other.Reset();
+        return *this;
+    };
+    RelativeUniquePtr& operator=(std::nullptr_t) noexcept {
+        this->Reset();
+        return *this;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Destructor
+
+    ~RelativeUniquePtr() {
+        this->Reset();
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Modifiers
+
+    T* Release() noexcept {
+        T* ret = Get();
+        pair_.GetFirst() = nullptr;
+        return ret;
+    };
+    void Reset(T* ptr = nullptr) noexcept {
+        T* el = Get();
+        pair_.GetFirst() = ptr;
+        if (el != nullptr) {
+            pair_.GetSecond()(el);
+        }
+    };
+    // Exchanges the pointees rather than the offsets, an offset is only valid at its own address
+    void Swap(RelativeUniquePtr& other) noexcept {
+        T* ptr = Get();
+        pair_.GetFirst() = other.Get();
+        other.pair_.GetFirst() = ptr;
+        std::swap(pair_.GetSecond(), other.pair_.GetSecond());
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    T* Get() const noexcept {
+        return pair_.GetFirst().Get();
+    };
+    Deleter& GetDeleter() noexcept {
+        return pair_.GetSecond();
+    };
+    const Deleter& GetDeleter() const noexcept {
+        return pair_.GetSecond();
+    };
+    explicit operator bool() const noexcept {
+        return Get() != nullptr;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Single-object dereference operators
+
+    T& operator*() const noexcept {
+        return *Get();
+    };
+    T* operator->() const noexcept {
+        return Get();
+    };
+
+private:
+    CompressedPair<RelativePtr<T, Offset>, Deleter> pair_;
+};
@@ -0,0 +1,153 @@
+#include "relative.h"
+
+#include <catch.hpp>
+
+#include <common/my_int.h>
+
+#include <cstring>
+#include <memory>
+#include <new>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct NoDelete {
+    template <typename T>
+    void operator()(T*) {
+    }
+};
+
+struct ListNode {
+    int value = 0;
+    RelativePtr<ListNode, int32_t> next;
+};
+
+struct Tree {
+    int value = 0;
+    RelativeUniquePtr<Tree, NoDelete, int32_t> left;
+    RelativeUniquePtr<Tree, NoDelete, int32_t> right;
+};
+
+TEST_CASE("RelativePtr") {
+    SECTION("Sizeof") {
+        static_assert(sizeof(RelativePtr<int>) == 8);
+        static_assert(sizeof(RelativePtr<int, int32_t>) == 4);
+        static_assert(sizeof(RelativeUniquePtr<int, NoDelete, int32_t>) == 4);
+    }
+
+    SECTION("Null") {
+        RelativePtr<int> p;
+        RelativePtr<int> q = nullptr;
+
+        REQUIRE(!p);
+        REQUIRE(p.Get() == nullptr);
+        REQUIRE(q.Get() == nullptr);
+    }
+
+    SECTION("Points to the object") {
+        int x = 42;
+        RelativePtr<int> p = &x;
+        RelativePtr<int> q = p;
+
+        REQUIRE(p.Get() == &x);
+        REQUIRE(q.Get() == &x);
+        REQUIRE(*q == 42);
+        REQUIRE(p == q);
+        REQUIRE(p.GetOffset() != q.GetOffset());
+    }
+
+    SECTION("Survives memcpy of the whole block") {
+        ListNode nodes[4];
+        for (int i = 0; i < 4; ++i) {
+            nodes[i].value = i;
+            if (i + 1 < 4) {
+                nodes[i].next = &nodes[i + 1];
+            }
+        }
+
+        auto copy = std::make_unique<ListNode[]>(4);
+        std::memcpy(static_cast<void*>(copy.get()), nodes, sizeof(nodes));
+        std::memset(static_cast<void*>(nodes), 0, sizeof(nodes));
+
+        int sum = 0;
+        for (ListNode* node = &copy[0]; node != nullptr; node = node->next.Get()) {
+            REQUIRE(node >= &copy[0]);
+            REQUIRE(node < &copy[4]);
+            sum += node->value;
+        }
+        REQUIRE(sum == 6);
+    }
+}
+
+TEST_CASE("RelativeUniquePtr") {
+    SECTION("Lifetime") {
+        {
+            RelativeUniquePtr<MyInt> p(new MyInt(1));
+            REQUIRE(MyInt::AliveCount() == 1);
+            REQUIRE(*p == 1);
+        }
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Move") {
+        RelativeUniquePtr<MyInt> p(new MyInt(1));
+        RelativeUniquePtr<MyInt> q(new MyInt(2));
+        MyInt* raw = p.Get();
+        q = std::move(p);
+
+        REQUIRE(MyInt::AliveCount() == 1);
+        REQUIRE(q.Get() == raw);
+        REQUIRE(!p);
+
+        RelativeUniquePtr<MyInt> r(std::move(q));
+        REQUIRE(r.Get() == raw);
+        REQUIRE(!q);
+    }
+
+    SECTION("Release and Reset") {
+        RelativeUniquePtr<MyInt> p(new MyInt(1));
+        MyInt* raw = p.Release();
+
+        REQUIRE(!p);
+        p.Reset(raw);
+        REQUIRE(p.Get() == raw);
+        p = nullptr;
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Move between pointers far from the stack") {
+        struct Block {
+            MyInt first{1};
+            MyInt second{2};
+            RelativeUniquePtr<MyInt, NoDelete, int32_t> p;
+            RelativeUniquePtr<MyInt, NoDelete, int32_t> q;
+        };
+        auto block = std::make_unique<Block>();
+        block->p.Reset(&block->first);
+        block->q.Reset(&block->second);
+
+        block->p.Swap(block->q);
+        REQUIRE(block->p.Get() == &block->second);
+        REQUIRE(block->q.Get() == &block->first);
+
+        block->p = std::move(block->q);
+        REQUIRE(block->p.Get() == &block->first);
+        REQUIRE(!block->q);
+    }
+
+    SECTION("Tree in a relocatable arena") {
+        alignas(Tree) unsigned char arena[3 * sizeof(Tree)];
+        Tree* root = ::new (arena) Tree{1, {}, {}};
+        root->left.Reset(::new (arena + sizeof(Tree)) Tree{2, {}, {}});
+        root->right.Reset(::new (arena + 2 * sizeof(Tree)) Tree{3, {}, {}});
+
+        alignas(Tree) unsigned char moved[sizeof(arena)];
+        std::memcpy(moved, arena, sizeof(arena));
+        std::memset(arena, 0, sizeof(arena));
+
+        Tree* copy = std::launder(reinterpret_cast<Tree*>(moved));
+        REQUIRE(copy->value == 1);
+        REQUIRE(copy->left->value == 2);
+        REQUIRE(copy->right->value == 3);
+        REQUIRE(!copy->left->left);
+    }
+}
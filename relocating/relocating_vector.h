@@ -0,0 +1,230 @@
+#pragma once
+
+#include <common/trivially_relocatable.h>
+
+#include <cassert>
+#include <cstddef>  // size_t
+#include <cstring>  // std::memmove
+#include <memory>   // std::allocator
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Moves `count` objects from `from` to `to` and ends the lifetime of the sources.
+// The ranges may overlap.
+template <typename T>
+void RelocateElements(T* from, size_t count, T* to) noexcept {
+    if (count == 0 || from == to) {
+        return;
+    }
+    if constexpr (kIsTriviallyRelocatable<T>) {
+        std::memmove(static_cast<void*>(to), static_cast<const void*>(from), count * sizeof(T));
+    } else if (to < from) {
+        for (size_t i = 0; i < count; ++i) {
+            ::new (to + i) T(std::move(from[i]));
+            from[i].~T();
+        }
+    } else {
+        for (size_t i = count; i > 0; --i) {
+            ::new (to + i - 1) T(std::move(from[i - 1]));
+            from[i - 1].~T();
+        }
+    }
+}
+
+// Vector that moves its elements with `memmove` when they are trivially relocatable:
+// growth, insertion and erasure run no move constructors and no destructors for them.
+template <typename T>
+class RelocatingVector {
+public:
+    static_assert(kIsTriviallyRelocatable<T> || std::is_nothrow_move_constructible_v<T>);
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    RelocatingVector() noexcept = default;
+
+    RelocatingVector(const RelocatingVector& other) {
+        Reserve(other.size_);
+        try {
+            for (size_t i = 0; i < other.size_; ++i) {
+                ::new (data_ + i) T(other.data_[i]);
+                ++size_;
+            }
+        } catch (...) {
+            // The destructor does not run for a constructor that throws
+            Clear();
+            Deallocate(data_, capacity_);
+            throw;
+        }
+    };
+    RelocatingVector(RelocatingVector&& other) noexcept {
+        this->Swap(other);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // `operator=`-s
+
+    RelocatingVector& operator=(const RelocatingVector& other) {
+        if (this == &other) {
+            return *this;
+        }
+        RelocatingVector copy(other);
+        this->Swap(copy);
+        return *this;
+    };
+    RelocatingVector& operator=(RelocatingVector&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        RelocatingVector tmp(std::move(other));
+        this->Swap(tmp);
+        return *this;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Destructor
+
+    ~RelocatingVector() {
+        Clear();
+        Deallocate(data_, capacity_);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Modifiers
+
+    void Reserve(size_t capacity) {
+        if (capacity <= capacity_) {
+            return;
+        }
+        T* data = std::allocator<T>().allocate(capacity);
+        RelocateElements(data_, size_, data);
+        Deallocate(data_, capacity_);
+        data_ = data;
+        capacity_ = capacity;
+    };
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    };
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    };
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ == capacity_) {
+            // Arguments may refer to our own elements, construct before growing
+            alignas(T) unsigned char slot[sizeof(T)];
+            T* value = ::new (slot) T(std::forward<Args>(args)...);
+            GrowOrDestroy(value);
+            RelocateElements(value, 1, data_ + size_);
+        } else {
+            ::new (data_ + size_) T(std::forward<Args>(args)...);
+        }
+        return data_[size_++];
+    };
+    // Constructs an element before position `index`, shifting the tail by one slot.
+    template <typename... Args>
+    T& Emplace(size_t index, Args&&... args) {
+        assert(index <= size_);
+        alignas(T) unsigned char slot[sizeof(T)];
+        T* value = ::new (slot) T(std::forward<Args>(args)...);
+        if (size_ == capacity_) {
+            GrowOrDestroy(value);
+        }
+        RelocateElements(data_ + index, size_ - index, data_ + index + 1);
+        RelocateElements(value, 1, data_ + index);
+        ++size_;
+        return data_[index];
+    };
+    void Insert(size_t index, const T& value) {
+        Emplace(index, value);
+    };
+    void Insert(size_t index, T&& value) {
+        Emplace(index, std::move(value));
+    };
+    void Erase(size_t index) {
+        assert(index < size_);
+        data_[index].~T();
+        RelocateElements(data_ + index + 1, size_ - index - 1, data_ + index);
+        --size_;
+    };
+    void PopBack() {
+        assert(size_ > 0);
+        data_[--size_].~T();
+    };
+    void Clear() noexcept {
+        while (size_ > 0) {
+            data_[--size_].~T();
+        }
+    };
+    void Swap(RelocatingVector& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    size_t Size() const noexcept {
+        return size_;
+    };
+    size_t Capacity() const noexcept {
+        return capacity_;
+    };
+    bool Empty() const noexcept {
+        return size_ == 0;
+    };
+    T* Data() noexcept {
+        return data_;
+    };
+    const T* Data() const noexcept {
+        return data_;
+    };
+    T& operator[](size_t index) noexcept {
+        return data_[index];
+    };
+    const T& operator[](size_t index) const noexcept {
+        return data_[index];
+    };
+    T* begin() noexcept {  // NOLINT
+        return data_;
+    };
+    T* end() noexcept {  // NOLINT
+        return data_ + size_;
+    };
+    const T* begin() const noexcept {  // NOLINT
+        return data_;
+    };
+    const T* end() const noexcept {  // NOLINT
+        return data_ + size_;
+    };
+
+private:
+    size_t NextCapacity() const noexcept {
+        return capacity_ == 0 ? 1 : 2 * capacity_;
+    }
+
+    // `pending` is an element constructed outside of the buffer, it must not leak on `bad_alloc`
+    void GrowOrDestroy(T* pending) {
+        try {
+            Reserve(NextCapacity());
+        } catch (...) {
+            pending->~T();
+            throw;
+        }
+    }
+
+    static void Deallocate(T* data, size_t capacity) noexcept {
+        if (data != nullptr) {
+            std::allocator<T>().deallocate(data, capacity);
+        }
+    }
+
+    T* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
+
+template <typename T>
+struct IsTriviallyRelocatable<RelocatingVector<T>> : std::true_type {};
@@ -0,0 +1,196 @@
+#include "relocating_vector.h"
+
+#include <intrusive/intrusive.h>
+#include <shared-from-this/shared.h>
+#include <shared-from-this/weak.h>
+#include <unique/unique.h>
+
+#include <catch.hpp>
+
+#include <common/my_int.h>
+
+#include <stdexcept>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Node : SimpleRefCounted<Node> {
+    explicit Node(int value) : value(value) {
+    }
+
+    int value;
+};
+
+TEST_CASE("Trait") {
+    SECTION("Smart pointers are trivially relocatable") {
+        static_assert(kIsTriviallyRelocatable<UniquePtr<int>>);
+        static_assert(kIsTriviallyRelocatable<UniquePtr<int[]>>);
+        static_assert(kIsTriviallyRelocatable<SharedPtr<int>>);
+        static_assert(kIsTriviallyRelocatable<WeakPtr<int>>);
+        static_assert(kIsTriviallyRelocatable<IntrusivePtr<Node>>);
+        static_assert(kIsTriviallyRelocatable<RelocatingVector<std::string>>);
+    }
+
+    SECTION("Unless their parts are not") {
+        struct Pinned {
+            Pinned() = default;
+            Pinned(const Pinned&) {
+            }
+            void operator()(int* p) {
+                delete p;
+            }
+        };
+
+        static_assert(!kIsTriviallyRelocatable<UniquePtr<int, Pinned>>);
+        static_assert(!kIsTriviallyRelocatable<std::string>);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Growth") {
+    SECTION("UniquePtr") {
+        {
+            RelocatingVector<UniquePtr<MyInt>> v;
+            for (int i = 0; i < 100; ++i) {
+                v.EmplaceBack(new MyInt(i));
+            }
+
+            REQUIRE(v.Size() == 100);
+            REQUIRE(v.Capacity() >= 100);
+            REQUIRE(MyInt::AliveCount() == 100);
+            for (int i = 0; i < 100; ++i) {
+                REQUIRE(*v[i] == i);
+            }
+        }
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("SharedPtr counts are untouched") {
+        auto sp = MakeShared<int>(5);
+        WeakPtr<int> wp = sp;
+        RelocatingVector<SharedPtr<int>> v;
+        RelocatingVector<WeakPtr<int>> w;
+        for (int i = 0; i < 10; ++i) {
+            v.PushBack(sp);
+            w.PushBack(wp);
+        }
+
+        REQUIRE(sp.UseCount() == 11);
+        v.Clear();
+        REQUIRE(sp.UseCount() == 1);
+        sp.Reset();
+        REQUIRE(w[9].Expired());
+    }
+
+    SECTION("Self-referencing argument") {
+        RelocatingVector<IntrusivePtr<Node>> v;
+        v.PushBack(MakeIntrusive<Node>(1));
+        for (int i = 0; i < 10; ++i) {
+            v.PushBack(v[0]);
+        }
+
+        REQUIRE(v[0].UseCount() == 11);
+        REQUIRE(v[10]->value == 1);
+    }
+
+    SECTION("Not relocatable elements") {
+        RelocatingVector<std::string> v;
+        for (int i = 0; i < 20; ++i) {
+            v.PushBack(std::string(30, 'a' + i));
+        }
+        RelocatingVector<std::string> copy = v;
+
+        REQUIRE(copy.Size() == 20);
+        REQUIRE(copy[19] == std::string(30, 'a' + 19));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Insert and erase") {
+    SECTION("Relocatable") {
+        {
+            RelocatingVector<UniquePtr<MyInt>> v;
+            for (int i = 0; i < 5; ++i) {
+                v.EmplaceBack(new MyInt(i));
+            }
+            v.Emplace(0, new MyInt(-1));
+            v.Insert(3, UniquePtr<MyInt>(new MyInt(100)));
+            v.Erase(1);
+            v.PopBack();
+
+            REQUIRE(MyInt::AliveCount() == 5);
+            REQUIRE(v.Size() == 5);
+            REQUIRE(*v[0] == -1);
+            REQUIRE(*v[1] == 1);
+            REQUIRE(*v[2] == 100);
+            REQUIRE(*v[3] == 2);
+            REQUIRE(*v[4] == 3);
+        }
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Not relocatable") {
+        RelocatingVector<std::string> v;
+        v.PushBack("b");
+        v.PushBack("d");
+        v.Insert(0, "a");
+        v.Insert(2, "c");
+        v.Insert(4, "e");
+        v.Erase(1);
+
+        std::string joined;
+        for (const auto& s : v) {
+            joined += s;
+        }
+        REQUIRE(joined == "acde");
+    }
+
+    SECTION("Move") {
+        RelocatingVector<SharedPtr<int>> v;
+        v.PushBack(MakeShared<int>(1));
+        RelocatingVector<SharedPtr<int>> w = std::move(v);
+
+        REQUIRE(v.Empty());
+        REQUIRE(*w[0] == 1);
+        v = std::move(w);
+        REQUIRE(*v[0] == 1);
+    }
+}
+
+// Copies throw once `copies_left` runs out
+struct Fragile {
+    Fragile() {
+        ++alive;
+    }
+    Fragile(const Fragile&) {
+        if (--copies_left < 0) {
+            throw std::runtime_error("copy");
+        }
+        ++alive;
+    }
+    Fragile(Fragile&&) noexcept {
+        ++alive;
+    }
+    ~Fragile() {
+        --alive;
+    }
+
+    static inline int alive = 0;
+    static inline int copies_left = 0;
+};
+
+TEST_CASE("Copy") {
+    RelocatingVector<Fragile> v;
+    for (int i = 0; i < 4; ++i) {
+        v.EmplaceBack();
+    }
+    Fragile::copies_left = 4;
+    RelocatingVector<Fragile> w = v;
+    REQUIRE(w.Size() == 4);
+
+    Fragile::copies_left = 2;
+    REQUIRE_THROWS_AS(RelocatingVector<Fragile>(v), std::runtime_error);
+    REQUIRE(Fragile::alive == 8);
+}
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <intrusive/intrusive.h>
+#include <weak/shared.h>
+#include <weak/weak.h>
+
+#include <any>
+#include <cstdint>  // uint8_t, uint64_t
+#include <cstring>  // std::memcpy
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Binary serialization of object graphs that keeps sharing: an object reached through several
+// `SharedPtr`, `WeakPtr` or `IntrusivePtr` edges is written once, later edges write
+// a back-reference, and loading restores the same aliasing, cycles included.
+//
+// A type takes part by listing its fields, the same member serves both directions:
+//
+//     template <typename Archive>
+//     void Serialize(Archive& archive) {
+//         archive(name, children, parent);
+//     }
+//
+// Arithmetic types, enums, strings, vectors and trivially copyable types without `Serialize`
+// are built in; trivially copyable data is copied as a whole. The format is the memory
+// layout of the host, so snapshots are read on the same architecture.
+// Pointers are followed by their static type, hierarchies are not supported.
+
+class SerializationError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+template <typename T, typename Archive>
+concept Serializable = requires(T& value, Archive& archive) { value.Serialize(archive); };
+
+namespace serialization {
+
+// Tags of pointer edges
+enum class Edge : uint8_t {
+    kNull = 0,
+    kNew = 1,      // Followed by the object
+    kBackRef = 2,  // Followed by the number of an object written before
+};
+
+template <typename T>
+struct IsVector : std::false_type {};
+template <typename T, typename Allocator>
+struct IsVector<std::vector<T, Allocator>> : std::true_type {};
+
+// Vectors whose elements are copied as a whole; `std::vector<bool>` packs its bits
+template <typename T, typename Archive, typename Element = typename T::value_type>
+inline constexpr bool kIsBulkVector = std::is_trivially_copyable_v<Element> &&
+                                      !std::is_same_v<Element, bool> &&
+                                      !Serializable<Element, Archive>;
+
+// An object is identified by its type and address: a member at the start of an object
+// has the same address as the object
+using ObjectKey = std::pair<std::type_index, const void*>;
+
+struct ObjectKeyHash {
+    size_t operator()(const ObjectKey& key) const noexcept {
+        return std::hash<std::type_index>()(key.first) * 31 + std::hash<const void*>()(key.second);
+    }
+};
+
+}  // namespace serialization
+
+class Writer {
+public:
+    template <typename... Args>
+    void operator()(const Args&... values) {
+        (Write(values), ...);
+    };
+
+    const std::string& Data() const noexcept {
+        return data_;
+    };
+
+private:
+    using Edge = serialization::Edge;
+
+    template <typename T>
+    void Write(const T& value) {
+        if constexpr (Serializable<T, Writer>) {
+            // `Serialize` is shared with `Reader`, so it is not const; the writer only reads
+            const_cast<T&>(value).Serialize(*this);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            Write(static_cast<uint64_t>(value.size()));
+            WriteBytes(value.data(), value.size());
+        } else if constexpr (serialization::IsVector<T>::value) {
+            Write(static_cast<uint64_t>(value.size()));
+            if constexpr (serialization::kIsBulkVector<T, Writer>) {
+                WriteBytes(value.data(), value.size() * sizeof(typename T::value_type));
+            } else {
+                for (const auto& element : value) {
+                    Write(element);
+                }
+            }
+        } else {
+            static_assert(std::is_trivially_copyable_v<T>, "Add a `Serialize` member");
+            WriteBytes(&value, sizeof(T));
+        }
+    }
+    template <typename T>
+    void Write(const SharedPtr<T>& ptr) {
+        WriteEdge(ptr.Get());
+    }
+    // An expired pointer is written as null
+    template <typename T>
+    void Write(const WeakPtr<T>& ptr) {
+        WriteEdge(ptr.Lock().Get());
+    }
+    template <typename T>
+    void Write(const IntrusivePtr<T>& ptr) {
+        WriteEdge(ptr.Get());
+    }
+
+    // The number is given before the object is written, so edges back into it are back-refs
+    template <typename T>
+    void WriteEdge(T* object) {
+        if (object == nullptr) {
+            Write(Edge::kNull);
+            return;
+        }
+        auto [it, inserted] =
+            ids_.emplace(serialization::ObjectKey(typeid(T), object), ids_.size());
+        if (!inserted) {
+            Write(Edge::kBackRef);
+            Write(static_cast<uint64_t>(it->second));
+            return;
+        }
+        Write(Edge::kNew);
+        Write(*object);
+    }
+
+    void WriteBytes(const void* bytes, size_t size) {
+        data_.append(static_cast<const char*>(bytes), size);
+    }
+
+    std::string data_;
+    // Objects written so far and their numbers
+    std::unordered_map<serialization::ObjectKey, size_t, serialization::ObjectKeyHash> ids_;
+};
+
+// Rebuilds objects with `MakeShared` and `MakeIntrusive`, so loaded types are default
+// constructible. The reader holds every loaded object until it is destroyed: an object
+// reachable only through `WeakPtr` edges lives as long as the reader.
+class Reader {
+public:
+    explicit Reader(std::string_view data) : data_(data) {
+    }
+
+    template <typename... Args>
+    void operator()(Args&... values) {
+        (Read(values), ...);
+    };
+
+    bool AtEnd() const noexcept {
+        return position_ == data_.size();
+    };
+
+private:
+    using Edge = serialization::Edge;
+
+    template <typename T>
+    void Read(T& value) {
+        if constexpr (Serializable<T, Reader>) {
+            value.Serialize(*this);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            value.resize(ReadSize(1));
+            ReadBytes(value.data(), value.size());
+        } else if constexpr (serialization::IsVector<T>::value) {
+            using Element = typename T::value_type;
+            if constexpr (serialization::kIsBulkVector<T, Reader>) {
+                value.resize(ReadSize(sizeof(Element)));
+                ReadBytes(value.data(), value.size() * sizeof(Element));
+            } else {
+                value.resize(ReadSize(1));
+                for (auto&& element : value) {
+                    if constexpr (std::is_same_v<Element, bool>) {
+                        // A proxy to one bit
+                        bool bit;
+                        Read(bit);
+                        element = bit;
+                    } else {
+                        Read(element);
+                    }
+                }
+            }
+        } else {
+            static_assert(std::is_trivially_copyable_v<T>, "Add a `Serialize` member");
+            ReadBytes(&value, sizeof(T));
+        }
+    }
+    template <typename T>
+    void Read(SharedPtr<T>& ptr) {
+        ReadEdge(ptr, [] { return MakeShared<T>(); });
+    }
+    template <typename T>
+    void Read(WeakPtr<T>& ptr) {
+        SharedPtr<T> strong;
+        Read(strong);
+        ptr = strong;
+    }
+    template <typename T>
+    void Read(IntrusivePtr<T>& ptr) {
+        ReadEdge(ptr, [] { return MakeIntrusive<T>(); });
+    }
+
+    // The object is registered before its fields are read, so cycles resolve to it
+    template <typename Ptr, typename Make>
+    void ReadEdge(Ptr& ptr, Make make) {
+        Edge edge;
+        Read(edge);
+        switch (edge) {
+            case Edge::kNull:
+                ptr = Ptr();
+                return;
+            case Edge::kBackRef: {
+                uint64_t id;
+                Read(id);
+                if (id >= objects_.size()) {
+                    throw SerializationError("Reference to an object that was not read");
+                }
+                const Ptr* known = std::any_cast<Ptr>(&objects_[id]);
+                if (known == nullptr) {
+                    throw SerializationError("Object read back as another type");
+                }
+                ptr = *known;
+                return;
+            }
+            case Edge::kNew: {
+                Ptr object = make();
+                objects_.emplace_back(object);
+                Read(*object);
+                ptr = object;
+                return;
+            }
+        }
+        throw SerializationError("Unknown pointer tag");
+    }
+
+    // Checks a size against the remaining input before anything is allocated for it
+    size_t ReadSize(size_t element_size) {
+        uint64_t size;
+        Read(size);
+        if (size > (data_.size() - position_) / element_size) {
+            throw SerializationError("Size exceeds the input");
+        }
+        return static_cast<size_t>(size);
+    }
+
+    void ReadBytes(void* bytes, size_t size) {
+        if (size > data_.size() - position_) {
+            throw SerializationError("Unexpected end of input");
+        }
+        std::memcpy(bytes, data_.data() + position_, size);
+        position_ += size;
+    }
+
+    std::string_view data_;
+    size_t position_ = 0;
+    // Loaded objects by number, as `SharedPtr<T>` or `IntrusivePtr<T>`
+    std::vector<std::any> objects_;
+};
+
+// Writes `values` into a new buffer
+template <typename... Args>
+std::string Serialize(const Args&... values) {
+    Writer writer;
+    writer(values...);
+    return writer.Data();
+};
+
+// Reads `values` written by `Serialize` in the same order
+template <typename... Args>
+void Deserialize(std::string_view data, Args&... values) {
+    Reader reader(data);
+    reader(values...);
+    if (!reader.AtEnd()) {
+        throw SerializationError("Trailing data");
+    }
+};
@@ -0,0 +1,166 @@
+#include "archive.h"
+
+#include <catch.hpp>
+
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Point {
+    double x;
+    double y;
+};
+
+struct Texture {
+    std::string name;
+    std::vector<uint8_t> pixels;
+
+    template <typename Archive>
+    void Serialize(Archive& archive) {
+        archive(name, pixels);
+    }
+};
+
+struct Sprite {
+    Point position;
+    SharedPtr<Texture> texture;
+
+    template <typename Archive>
+    void Serialize(Archive& archive) {
+        archive(position, texture);
+    }
+};
+
+struct TreeNode {
+    int value = 0;
+    std::vector<SharedPtr<TreeNode>> children;
+    WeakPtr<TreeNode> parent;
+
+    template <typename Archive>
+    void Serialize(Archive& archive) {
+        archive(value, children, parent);
+    }
+};
+
+struct ListNode : SimpleRefCounted<ListNode> {
+    std::string label;
+    IntrusivePtr<ListNode> next;
+
+    template <typename Archive>
+    void Serialize(Archive& archive) {
+        archive(label, next);
+    }
+};
+
+TEST_CASE("Serialization of values") {
+    int number = 42;
+    std::string text = "snapshot";
+    std::vector<Point> points = {{1, 2}, {3, 4}};
+    std::vector<bool> flags = {true, false, true};
+    std::string data = Serialize(number, text, points, flags);
+
+    int number_out = 0;
+    std::string text_out;
+    std::vector<Point> points_out;
+    std::vector<bool> flags_out;
+    Deserialize(data, number_out, text_out, points_out, flags_out);
+
+    REQUIRE(number_out == 42);
+    REQUIRE(text_out == "snapshot");
+    REQUIRE(points_out.size() == 2);
+    REQUIRE(points_out[1].y == 4);
+    REQUIRE(flags_out == flags);
+}
+
+TEST_CASE("Shared objects are written once") {
+    auto texture = MakeShared<Texture>();
+    texture->name = "grass";
+    texture->pixels.assign(4096, 7);
+
+    std::vector<Sprite> sprites(100);
+    for (size_t i = 0; i < sprites.size(); ++i) {
+        sprites[i].position = {static_cast<double>(i), 0};
+        sprites[i].texture = texture;
+    }
+    sprites[50].texture = nullptr;
+
+    std::string data = Serialize(sprites);
+    REQUIRE(data.size() < 2 * 4096);
+
+    std::vector<Sprite> loaded;
+    Deserialize(data, loaded);
+
+    REQUIRE(loaded.size() == 100);
+    REQUIRE(loaded[50].texture.Get() == nullptr);
+    REQUIRE(loaded[0].texture.Get() == loaded[99].texture.Get());
+    REQUIRE(loaded[0].texture->pixels == texture->pixels);
+    REQUIRE(loaded[99].position.x == 99);
+    REQUIRE(loaded[0].texture.UseCount() == 99);
+}
+
+TEST_CASE("Cycles through weak pointers") {
+    auto root = MakeShared<TreeNode>();
+    root->value = 1;
+    for (int i = 2; i <= 3; ++i) {
+        auto child = MakeShared<TreeNode>();
+        child->value = i;
+        child->parent = root;
+        root->children.push_back(child);
+    }
+
+    SharedPtr<TreeNode> loaded;
+    Deserialize(Serialize(root), loaded);
+
+    REQUIRE(loaded->value == 1);
+    REQUIRE(loaded->children.size() == 2);
+    REQUIRE(loaded->children[1]->value == 3);
+    REQUIRE(loaded->children[0]->parent.Lock().Get() == loaded.Get());
+    REQUIRE(loaded.UseCount() == 1);
+}
+
+TEST_CASE("Objects of different types at one address") {
+    auto node = MakeShared<TreeNode>();
+    node->value = 5;
+    SharedPtr<int> value(node, &node->value);
+
+    SharedPtr<TreeNode> node_out;
+    SharedPtr<int> value_out;
+    Deserialize(Serialize(node, value), node_out, value_out);
+
+    REQUIRE(node_out->value == 5);
+    REQUIRE(*value_out == 5);
+}
+
+TEST_CASE("Intrusive lists") {
+    auto shared_tail = MakeIntrusive<ListNode>();
+    shared_tail->label = "tail";
+    auto a = MakeIntrusive<ListNode>();
+    a->label = "a";
+    a->next = shared_tail;
+    auto b = MakeIntrusive<ListNode>();
+    b->label = "b";
+    b->next = shared_tail;
+
+    IntrusivePtr<ListNode> a_out;
+    IntrusivePtr<ListNode> b_out;
+    Deserialize(Serialize(a, b), a_out, b_out);
+
+    REQUIRE(a_out->label == "a");
+    REQUIRE(b_out->next->label == "tail");
+    REQUIRE(a_out->next.Get() == b_out->next.Get());
+    REQUIRE(a_out->next.UseCount() == 2);
+}
+
+TEST_CASE("Malformed input") {
+    std::string data = Serialize(std::string("truncated"));
+    std::string out;
+
+    REQUIRE_THROWS_AS(Deserialize(data.substr(0, data.size() - 1), out), SerializationError);
+    REQUIRE_THROWS_AS(Deserialize(data + "x", out), SerializationError);
+
+    SharedPtr<Texture> texture;
+    REQUIRE_THROWS_AS(Deserialize(std::string(1, '\x07'), texture), SerializationError);
+    REQUIRE_THROWS_AS(Deserialize(Serialize(uint8_t{2}, uint64_t{0}), texture),
+                      SerializationError);
+}
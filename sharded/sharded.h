@@ -0,0 +1,186 @@
+#pragma once
+
+#include <common/trivially_relocatable.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>  // size_t, std::nullptr_t
+#include <new>
+#include <utility>
+
+// Cache line size, spelled out: `std::hardware_destructive_interference_size` is not ABI-stable
+inline constexpr size_t kCacheLineSize = 64;
+
+// Index of the counter slot used by the calling thread. Threads get slots round-robin.
+inline size_t CurrentShard(size_t shards) noexcept {
+    static std::atomic<size_t> next_thread{0};
+    thread_local size_t thread_index = next_thread.fetch_add(1, std::memory_order_relaxed);
+    return thread_index % shards;
+}
+
+// Control block with one reference counter per shard, each on its own cache line, plus
+// the number of shards that are in use. A reference is counted in the shard of the thread
+// that created it and released into the same shard from any thread; the shared
+// `active_` counter is touched only when a shard goes from 0 to 1 or back.
+// A `ShardedSharedPtr` whose shard count is above zero keeps its shard in `active_`, so
+// `active_` drops to zero only when no reference is left anywhere.
+template <typename T, size_t Shards>
+class ShardedControlBlock {
+public:
+    template <typename... Args>
+    explicit ShardedControlBlock(size_t shard, Args&&... args) {
+        ::new (static_cast<void*>(&object_)) T(std::forward<Args>(args)...);
+        shards_[shard].count.store(1, std::memory_order_relaxed);
+        active_.store(1, std::memory_order_relaxed);
+    }
+
+    ShardedControlBlock(const ShardedControlBlock&) = delete;
+    ShardedControlBlock& operator=(const ShardedControlBlock&) = delete;
+
+    void Acquire(size_t shard) noexcept {
+        if (shards_[shard].count.fetch_add(1, std::memory_order_relaxed) == 0) {
+            active_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    // Destroys the object and the block with the last reference
+    void Release(size_t shard) noexcept {
+        if (shards_[shard].count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        if (active_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Get()->~T();
+            delete this;
+        }
+    }
+
+    T* Get() noexcept {
+        return std::launder(reinterpret_cast<T*>(&object_));
+    }
+    // A snapshot, exact only when no other thread is copying or releasing
+    size_t UseCount() const noexcept {
+        size_t count = 0;
+        for (const auto& shard : shards_) {
+            count += shard.count.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+private:
+    struct alignas(kCacheLineSize) Shard {
+        std::atomic<size_t> count{0};
+    };
+
+    std::array<Shard, Shards> shards_;
+    alignas(kCacheLineSize) std::atomic<size_t> active_{0};
+    alignas(T) unsigned char object_[sizeof(T)];
+};
+
+// Shared pointer for a few objects that many threads copy all the time (a logger, a config).
+// Copies and destructions on different threads update different cache lines, so their
+// throughput grows with the number of threads instead of bouncing one counter between cores.
+// The price is a control block of `Shards + 1` cache lines, so it is opt-in and made only by
+// `MakeShardedShared`. Like `std::shared_ptr`, distinct instances may be used concurrently.
+template <typename T, size_t Shards = 16>
+class ShardedSharedPtr {
+public:
+    template <typename U, size_t S, typename... Args>
+    friend ShardedSharedPtr<U, S> MakeShardedShared(Args&&... args);
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    ShardedSharedPtr() noexcept = default;
+    ShardedSharedPtr(std::nullptr_t) noexcept {
+    }
+
+    // Counted in the shard of the calling thread
+    ShardedSharedPtr(const ShardedSharedPtr& other) noexcept : block_(other.block_) {
+        if (block_ != nullptr) {
+            shard_ = CurrentShard(Shards);
+            block_->Acquire(shard_);
+        }
+    };
+    ShardedSharedPtr(ShardedSharedPtr&& other) noexcept
+        : block_(std::exchange(other.block_, nullptr)), shard_(other.shard_) {
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // `operator=`-s
+
+    ShardedSharedPtr& operator=(const ShardedSharedPtr& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        ShardedSharedPtr copy(other);
+        this->Swap(copy);
+        return *this;
+    };
+    ShardedSharedPtr& operator=(ShardedSharedPtr&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        ShardedSharedPtr tmp(std::move(other));
+        this->Swap(tmp);
+        return *this;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Destructor
+
+    ~ShardedSharedPtr() {
+        if (block_ != nullptr) {
+            block_->Release(shard_);
+        }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Modifiers
+
+    void Reset() noexcept {
+        if (block_ != nullptr) {
+            std::exchange(block_, nullptr)->Release(shard_);
+        }
+    };
+    void Swap(ShardedSharedPtr& other) noexcept {
+        std::swap(block_, other.block_);
+        std::swap(shard_, other.shard_);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    T* Get() const noexcept {
+        return block_ != nullptr ? block_->Get() : nullptr;
+    };
+    T& operator*() const noexcept {
+        return *Get();
+    };
+    T* operator->() const noexcept {
+        return Get();
+    };
+    // Sums all shards, a snapshot under concurrent copying
+    size_t UseCount() const noexcept {
+        return block_ != nullptr ? block_->UseCount() : 0;
+    };
+    explicit operator bool() const noexcept {
+        return block_ != nullptr;
+    };
+
+private:
+    ShardedControlBlock<T, Shards>* block_ = nullptr;
+    // The shard that counts this reference
+    size_t shard_ = 0;
+};
+
+template <typename T, size_t Shards>
+struct IsTriviallyRelocatable<ShardedSharedPtr<T, Shards>> : std::true_type {};
+
+// Allocate memory only once
+template <typename T, size_t Shards = 16, typename... Args>
+ShardedSharedPtr<T, Shards> MakeShardedShared(Args&&... args) {
+    ShardedSharedPtr<T, Shards> result;
+    result.shard_ = CurrentShard(Shards);
+    result.block_ =
+        new ShardedControlBlock<T, Shards>(result.shard_, std::forward<Args>(args)...);
+    return result;
+};
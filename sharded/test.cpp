@@ -0,0 +1,98 @@
+#include "sharded.h"
+
+#include <catch.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Tracked {
+    static std::atomic<int> alive;
+
+    explicit Tracked(std::string name) : name(std::move(name)) {
+        ++alive;
+    }
+    ~Tracked() {
+        --alive;
+    }
+
+    std::string name;
+};
+
+std::atomic<int> Tracked::alive = 0;
+
+TEST_CASE("ShardedSharedPtr") {
+    SECTION("Empty") {
+        ShardedSharedPtr<int> empty;
+        ShardedSharedPtr<int> copy = empty;
+
+        REQUIRE(!copy);
+        REQUIRE(copy.Get() == nullptr);
+        REQUIRE(copy.UseCount() == 0);
+    }
+
+    SECTION("Copy, move and reset") {
+        auto logger = MakeShardedShared<Tracked>("logger");
+        auto copy = logger;
+        auto moved = std::move(copy);
+
+        REQUIRE(!copy);
+        REQUIRE(moved->name == "logger");
+        REQUIRE(logger.UseCount() == 2);
+
+        logger.Reset();
+        REQUIRE(Tracked::alive == 1);
+        moved = nullptr;
+        REQUIRE(Tracked::alive == 0);
+    }
+
+    SECTION("Assignment") {
+        auto a = MakeShardedShared<Tracked>("a");
+        auto b = MakeShardedShared<Tracked>("b");
+        a = b;
+
+        REQUIRE(Tracked::alive == 1);
+        REQUIRE(a->name == "b");
+        REQUIRE(b.UseCount() == 2);
+    }
+
+    SECTION("Copies on many threads") {
+        auto config = MakeShardedShared<Tracked, 4>("config");
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([config] {
+                std::vector<ShardedSharedPtr<Tracked, 4>> copies;
+                for (int i = 0; i < 1000; ++i) {
+                    copies.push_back(config);
+                    if (i % 3 == 0) {
+                        copies.pop_back();
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        REQUIRE(config.UseCount() == 1);
+        config.Reset();
+        REQUIRE(Tracked::alive == 0);
+    }
+
+    SECTION("References released on other threads") {
+        std::vector<ShardedSharedPtr<Tracked, 2>> copies;
+        {
+            auto registry = MakeShardedShared<Tracked, 2>("registry");
+            for (int i = 0; i < 100; ++i) {
+                copies.push_back(registry);
+            }
+        }
+        std::thread releaser([&copies] { copies.clear(); });
+        releaser.join();
+
+        REQUIRE(Tracked::alive == 0);
+    }
+}
@@ -2,9 +2,86 @@
 
 #include "sw_fwd.h"  // Forward declaration
 
+#include <common/fast_dynamic_cast.h>
+#include <common/trivially_relocatable.h>
+#include <unique/unique.h>
+
 #include <cstddef>  // std::nullptr_t
 #include <type_traits>
 
+template <typename T, typename Deleter>
+class ControlBlockWithDeleter : public ControlBlock {
+public:
+    size_t UseStrongCount() override {
+        return strong_counter_;
+    }
+    size_t UseWeakCount() override {
+        return weak_counter_;
+    }
+    void IncrementStrong() override {
+        ++strong_counter_;
+    }
+    void AddStrong(size_t count) override {
+        strong_counter_ += count;
+    }
+    bool TryIncrementStrong() override {
+        if (strong_counter_ == 0) {
+            return false;
+        }
+        ++strong_counter_;
+        return true;
+    }
+    void DecrementStrong() override {
+        --strong_counter_;
+    }
+    void DeleteObject() override {
+        pair_.GetSecond()(pair_.GetFirst());
+    }
+    void IncrementWeak() override {
+        ++weak_counter_;
+    }
+    void DecrementWeak() override {
+        --weak_counter_;
+    }
+    ControlBlockWithDeleter(T* ptr, Deleter&& deleter) : pair_(ptr, std::move(deleter)) {
+        strong_counter_ = 1;
+        weak_counter_ = 0;
+    }
+    ~ControlBlockWithDeleter(){};
+
+private:
+    size_t strong_counter_{};
+    size_t weak_counter_{};
+    CompressedPair<T*, Deleter> pair_;
+};
+
+// Deleter of `UniquePtr`-s made by `MakeUniqueShareable`.
+// The object already lives inside a control block, so promotion to `SharedPtr` is free.
+template <typename T>
+class ShareableDelete {
+public:
+    template <typename Y>
+    friend class SharedPtr;
+
+    ShareableDelete() = default;
+    explicit ShareableDelete(ControlBlockWithObject<T>* block) : block_(block) {
+    }
+    // Only a `SharedPtr<T>` can take over the block, no other deleter may stand in for it
+    template <typename D>
+    operator D() const = delete;
+
+    void operator()(T* ptr) {
+        if (ptr != nullptr) {
+            block_->DecrementStrong();
+            block_->DeleteObject();
+            delete block_;
+        }
+    }
+
+private:
+    ControlBlockWithObject<T>* block_ = nullptr;
+};
+
 // https://en.cppreference.com/w/cpp/memory/shared_ptr
 template <typename T>
 class SharedPtr {
@@ -13,6 +90,16 @@ public:
     friend class SharedPtr;
     template <typename Y>
     friend class WeakPtr;
+    template <typename Y>
+    friend class EnableSharedFromThis;
+    template <typename U, typename Y>
+    friend SharedPtr<U> StaticPointerCast(SharedPtr<Y>&& other);
+    template <typename U, typename Y>
+    friend SharedPtr<U> DynamicPointerCast(SharedPtr<Y>&& other);
+    template <typename U, typename Y>
+    friend SharedPtr<U> ConstPointerCast(SharedPtr<Y>&& other);
+    template <typename U, typename Y>
+    friend SharedPtr<U> FastDynamicPointerCast(SharedPtr<Y>&& other);
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Constructors
 
@@ -25,7 +112,10 @@ public:
         block_ = nullptr;
     };
     explicit SharedPtr(T* ptr) {
+        static_assert(!std::is_base_of_v<CompactESFTBase, T>,
+                      "Objects with EnableSharedFromThisCompact are created by MakeShared");
         object_ptr_ = ptr;
+        block_ = nullptr;
         if (ptr != nullptr) {
             block_ = new ControlBlockWithPtr<T>(ptr);
         }
@@ -35,7 +125,10 @@ public:
     };
     template <typename Y>
     explicit SharedPtr(Y* ptr) {
+        static_assert(!std::is_base_of_v<CompactESFTBase, Y>,
+                      "Objects with EnableSharedFromThisCompact are created by MakeShared");
         object_ptr_ = ptr;
+        block_ = nullptr;
         if (ptr != nullptr) {
             block_ = new ControlBlockWithPtr<Y>(ptr);
         }
@@ -51,6 +144,42 @@ public:
             InitWeakThis(ptr);
         }
     }
+    // Adopts the reference held by `block`
+    template <typename Y>
+    SharedPtr(ControlBlockBeforeObject<Y>* block, T* ptr) noexcept {
+        object_ptr_ = ptr;
+        block_ = block;
+    }
+    // Take over a `UniquePtr` together with its deleter
+    // #13 from https://en.cppreference.com/w/cpp/memory/shared_ptr/shared_ptr
+    template <typename Y, typename Deleter>
+    SharedPtr(UniquePtr<Y, Deleter>&& other) {
+        static_assert(!std::is_base_of_v<CompactESFTBase, Y>,
+                      "Objects with EnableSharedFromThisCompact are created by MakeShared");
+        object_ptr_ = other.Get();
+        block_ = nullptr;
+        if (other) {
+            block_ = new ControlBlockWithDeleter<Y, Deleter>(other.Get(),
+                                                             std::move(other.GetDeleter()));
+            other.Release();
+            if constexpr (std::is_convertible_v<T*, ESFTBase*>) {
+                InitWeakThis(object_ptr_);
+            }
+        }
+    }
+    // The control block was reserved by `MakeUniqueShareable`, no allocation here
+    template <typename Y>
+    SharedPtr(UniquePtr<Y, ShareableDelete<Y>>&& other) noexcept {
+        object_ptr_ = other.Get();
+        block_ = nullptr;
+        if (other) {
+            block_ = other.GetDeleter().block_;
+            other.Release();
+            if constexpr (std::is_convertible_v<T*, ESFTBase*>) {
+                InitWeakThis(object_ptr_);
+            }
+        }
+    }
 
     SharedPtr(const SharedPtr& other) noexcept {
         if (other) {
@@ -100,17 +229,28 @@ public:
             object_ptr_ = nullptr;
         }
     };
+    // Takes over the reference of `other` without touching the counter
+    template <typename Y>
+    SharedPtr(SharedPtr<Y>&& other, T* ptr) noexcept {
+        if (other) {
+            object_ptr_ = ptr;
+            block_ = other.block_;
+            other.object_ptr_ = nullptr;
+            other.block_ = nullptr;
+        } else {
+            block_ = nullptr;
+            object_ptr_ = nullptr;
+        }
+    };
 
     // Promote `WeakPtr`
     // #11 from https://en.cppreference.com/w/cpp/memory/shared_ptr/shared_ptr
     explicit SharedPtr(const WeakPtr<T>& other) {
-        if (other.Expired()) {
+        if (other.block_ == nullptr || !other.block_->TryIncrementStrong()) {
             throw BadWeakPtr();
-        } else {
-            object_ptr_ = other.object_ptr_;
-            block_ = other.block_;
-            block_->IncrementStrong();
         }
+        object_ptr_ = other.object_ptr_;
+        block_ = other.block_;
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -124,15 +264,7 @@ public:
             object_ptr_ = other.object_ptr_;
             return *this;
         }
-        if (*this) {
-            block_->DecrementStrong();
-            if (block_->UseStrongCount() == 0 && block_->UseWeakCount() == 0) {
-                block_->DeleteObject();
-                delete block_;
-            } else if (block_->UseStrongCount() == 0) {
-                block_->DeleteObject();
-            }
-        }
+        DropOwnership();
         object_ptr_ = other.object_ptr_;
         block_ = other.block_;
         if (other) {
@@ -161,15 +293,7 @@ public:
     // Destructor
 
     ~SharedPtr() {
-        if (*this) {
-            block_->DecrementStrong();
-            if (block_->UseStrongCount() == 0 && block_->UseWeakCount() == 0) {
-                block_->DeleteObject();
-                delete block_;
-            } else if (block_->UseStrongCount() == 0) {
-                block_->DeleteObject();
-            }
-        }
+        DropOwnership();
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -177,41 +301,23 @@ public:
 
     void Reset() noexcept {
         if (*this) {
-            block_->DecrementStrong();
-            if (block_->UseStrongCount() == 0 && block_->UseWeakCount() == 0) {
-                block_->DeleteObject();
-                delete block_;
-            } else if (block_->UseStrongCount() == 0) {
-                block_->DeleteObject();
-            }
+            DropOwnership();
             block_ = nullptr;
             object_ptr_ = nullptr;
         }
     };
     void Reset(T* ptr) {
-        if (*this) {
-            block_->DecrementStrong();
-            if (block_->UseStrongCount() == 0 && block_->UseWeakCount() == 0) {
-                block_->DeleteObject();
-                delete block_;
-            } else if (block_->UseStrongCount() == 0) {
-                block_->DeleteObject();
-            }
-        }
+        static_assert(!std::is_base_of_v<CompactESFTBase, T>,
+                      "Objects with EnableSharedFromThisCompact are created by MakeShared");
+        DropOwnership();
         object_ptr_ = ptr;
         block_ = new ControlBlockWithPtr(ptr);
     };
     template <typename Y>
     void Reset(Y* ptr) {
-        if (*this) {
-            block_->DecrementStrong();
-            if (block_->UseStrongCount() == 0 && block_->UseWeakCount() == 0) {
-                block_->DeleteObject();
-                delete block_;
-            } else if (block_->UseStrongCount() == 0) {
-                block_->DeleteObject();
-            }
-        }
+        static_assert(!std::is_base_of_v<CompactESFTBase, Y>,
+                      "Objects with EnableSharedFromThisCompact are created by MakeShared");
+        DropOwnership();
         object_ptr_ = ptr;
         block_ = new ControlBlockWithPtr(ptr);
     };
@@ -219,9 +325,38 @@ public:
         std::swap(object_ptr_, other.object_ptr_);
         std::swap(block_, other.block_);
     };
+    // Writes `count` copies of `*this` to `out` with a single counter update
+    template <typename OutputIt>
+    OutputIt ShareN(size_t count, OutputIt out) const {
+        if (count == 0) {
+            return out;
+        }
+        if (*this) {
+            block_->AddStrong(count);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            // Adopts one of the references added above
+            SharedPtr copy;
+            copy.object_ptr_ = object_ptr_;
+            copy.block_ = object_ptr_ != nullptr ? block_ : nullptr;
+            try {
+                *out = std::move(copy);
+            } catch (...) {
+                // `copy` gives back its own reference, return the ones not handed out yet
+                for (size_t j = i + 1; *this && j < count; ++j) {
+                    block_->DecrementStrong();
+                }
+                throw;
+            }
+            ++out;
+        }
+        return out;
+    };
     template <typename Y>
     void InitWeakThis(EnableSharedFromThis<Y>* e) {
-        e->SetWeak(*this);
+        if (e != nullptr) {
+            e->SetWeak(*this);
+        }
     }
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -247,46 +382,269 @@ public:
     };
 
 private:
+    // Takes over the reference of `other`, `ptr` is the same object seen as a `T`
+    template <typename Y>
+    static SharedPtr Adopt(SharedPtr<Y>&& other, T* ptr) noexcept {
+        return SharedPtr(std::move(other), ptr);
+    }
+
+    void DropOwnership() noexcept {
+        if (*this) {
+            block_->DecrementStrong();
+            if (block_->UseStrongCount() == 0) {
+                // The object may hold the last `WeakPtr` to itself, keep the block until it is gone
+                block_->IncrementWeak();
+                block_->DeleteObject();
+                block_->DecrementWeak();
+                if (block_->UseWeakCount() == 0) {
+                    delete block_;
+                }
+            }
+        }
+    }
+
     T* object_ptr_;
     ControlBlock* block_;
 };
 
+template <typename T>
+struct IsTriviallyRelocatable<SharedPtr<T>> : std::true_type {};
+
 template <typename T, typename U>
 inline bool operator==(const SharedPtr<T>& left, const SharedPtr<U>& right) {
     return left.Get() == right.Get();
 };
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Casts
+// https://en.cppreference.com/w/cpp/memory/shared_ptr/pointer_cast
+// The rvalue overloads move the reference from the source, the counter is not touched.
+// A failed dynamic cast returns an empty pointer and leaves the source as it was.
+
+template <typename T, typename Y>
+SharedPtr<T> StaticPointerCast(const SharedPtr<Y>& other) {
+    return SharedPtr<T>(other, static_cast<T*>(other.Get()));
+};
+template <typename T, typename Y>
+SharedPtr<T> StaticPointerCast(SharedPtr<Y>&& other) {
+    T* ptr = static_cast<T*>(other.Get());
+    return SharedPtr<T>::Adopt(std::move(other), ptr);
+};
+
+template <typename T, typename Y>
+SharedPtr<T> DynamicPointerCast(const SharedPtr<Y>& other) {
+    if (T* ptr = dynamic_cast<T*>(other.Get())) {
+        return SharedPtr<T>(other, ptr);
+    }
+    return SharedPtr<T>();
+};
+template <typename T, typename Y>
+SharedPtr<T> DynamicPointerCast(SharedPtr<Y>&& other) {
+    if (T* ptr = dynamic_cast<T*>(other.Get())) {
+        return SharedPtr<T>::Adopt(std::move(other), ptr);
+    }
+    return SharedPtr<T>();
+};
+
+template <typename T, typename Y>
+SharedPtr<T> ConstPointerCast(const SharedPtr<Y>& other) {
+    return SharedPtr<T>(other, const_cast<T*>(other.Get()));
+};
+template <typename T, typename Y>
+SharedPtr<T> ConstPointerCast(SharedPtr<Y>&& other) {
+    T* ptr = const_cast<T*>(other.Get());
+    return SharedPtr<T>::Adopt(std::move(other), ptr);
+};
+
+// `DynamicPointerCast` for closed hierarchies, see common/fast_dynamic_cast.h
+template <typename T, typename Y>
+SharedPtr<T> FastDynamicPointerCast(const SharedPtr<Y>& other) {
+    if (T* ptr = FastDynamicCast<T>(other.Get())) {
+        return SharedPtr<T>(other, ptr);
+    }
+    return SharedPtr<T>();
+};
+template <typename T, typename Y>
+SharedPtr<T> FastDynamicPointerCast(SharedPtr<Y>&& other) {
+    if (T* ptr = FastDynamicCast<T>(other.Get())) {
+        return SharedPtr<T>::Adopt(std::move(other), ptr);
+    }
+    return SharedPtr<T>();
+};
+
 // Allocate memory only once
 template <typename T, typename... Args>
 SharedPtr<T> MakeShared(Args&&... args) {
+    if constexpr (std::is_base_of_v<CompactESFTBase, T>) {
+        static_assert(std::is_base_of_v<EnableSharedFromThisCompact<T>, T>,
+                      "EnableSharedFromThisCompact<T> objects must be created as T");
+        ControlBlockBeforeObject<T>* block =
+            ControlBlockBeforeObject<T>::Create(std::forward<Args>(args)...);
+        return SharedPtr<T>(block, block->Get());
+    } else {
+        ControlBlockWithObject<T>* block =
+            new ControlBlockWithObject<T>(std::forward<Args>(args)...);
+        return SharedPtr(block, block->Get());
+    }
+};
+
+// For objects shared everywhere that never die: sentinels, empty defaults, interned constants.
+// The strong count starts above `ControlBlock::kImmortalRefCount`, like `RefCounted::MakeImmortal`:
+// copies and releases only read it, and the object and its block are never freed.
+// `UseCount` of the result is always 2. Keep it in a static to keep it reachable.
+template <typename T, typename... Args>
+SharedPtr<T> MakeImmortalShared(Args&&... args) {
+    if constexpr (std::is_base_of_v<CompactESFTBase, T>) {
+        static_assert(std::is_base_of_v<EnableSharedFromThisCompact<T>, T>,
+                      "EnableSharedFromThisCompact<T> objects must be created as T");
+        ControlBlockBeforeObject<T>* block =
+            ControlBlockBeforeObject<T>::Create(std::forward<Args>(args)...);
+        block->AddStrong(ControlBlock::kImmortalRefCount);
+        return SharedPtr<T>(block, block->Get());
+    } else {
+        ControlBlockWithObject<T>* block =
+            new ControlBlockWithObject<T>(std::forward<Args>(args)...);
+        block->AddStrong(ControlBlock::kImmortalRefCount);
+        return SharedPtr(block, block->Get());
+    }
+};
+
+// Same single allocation as `MakeShared`, but starts as a sole owner.
+// Moving the result into a `SharedPtr` reuses the reserved control block.
+template <typename T, typename... Args>
+UniquePtr<T, ShareableDelete<T>> MakeUniqueShareable(Args&&... args) {
+    static_assert(!std::is_base_of_v<CompactESFTBase, T>,
+                  "Objects with EnableSharedFromThisCompact are created by MakeShared");
     ControlBlockWithObject<T>* block = new ControlBlockWithObject<T>(std::forward<Args>(args)...);
-    return SharedPtr(block, block->Get());
+    return UniquePtr<T, ShareableDelete<T>>(block->Get(), ShareableDelete<T>(block));
 };
 
 class ESFTBase {};
 
 // Look for usage examples in tests
+// The `SharedPtr` constructors only record the owner, with no counter updates: the control
+// block outlives the object, so it can be used as long as the object is alive.
+// `SharedFromThis` and `WeakFromThis` build their pointers from it on demand.
 template <typename T>
 class EnableSharedFromThis : public ESFTBase {
 public:
     SharedPtr<T> SharedFromThis() {
-        return SharedPtr(weak_this_);
+        SharedPtr<T> result = TrySharedFromThis();
+        if (!result) {
+            throw BadWeakPtr();
+        }
+        return result;
     };
     SharedPtr<const T> SharedFromThis() const {
-        return SharedPtr(weak_this_);
+        SharedPtr<const T> result = TrySharedFromThis();
+        if (!result) {
+            throw BadWeakPtr();
+        }
+        return result;
+    };
+    // Empty instead of throwing if the object is not owned by a `SharedPtr` (anymore)
+    SharedPtr<T> TrySharedFromThis() noexcept {
+        SharedPtr<T> result;
+        if (block_ != nullptr && block_->TryIncrementStrong()) {
+            result.object_ptr_ = self_;
+            result.block_ = block_;
+        }
+        return result;
+    };
+    SharedPtr<const T> TrySharedFromThis() const noexcept {
+        SharedPtr<const T> result;
+        if (block_ != nullptr && block_->TryIncrementStrong()) {
+            result.object_ptr_ = self_;
+            result.block_ = block_;
+        }
+        return result;
     };
 
     WeakPtr<T> WeakFromThis() noexcept {
-        return WeakPtr<T>(weak_this_);
+        WeakPtr<T> result;
+        if (block_ != nullptr) {
+            block_->IncrementWeak();
+            result.object_ptr_ = self_;
+            result.block_ = block_;
+        }
+        return result;
     };
     WeakPtr<const T> WeakFromThis() const noexcept {
-        return WeakPtr<const T>(weak_this_);
+        WeakPtr<const T> result;
+        if (block_ != nullptr) {
+            block_->IncrementWeak();
+            result.object_ptr_ = self_;
+            result.block_ = block_;
+        }
+        return result;
     };
     template <typename Y>
-    void SetWeak(const SharedPtr<Y>& sp) {
-        weak_this_ = sp;
+    void SetWeak(const SharedPtr<Y>& sp) noexcept {
+        self_ = sp.object_ptr_;
+        block_ = sp.block_;
     }
 
 protected:
-    WeakPtr<T> weak_this_;
+    EnableSharedFromThis() noexcept = default;
+    // A copy is a new object, it is not owned by the owner of the source
+    EnableSharedFromThis(const EnableSharedFromThis&) noexcept {
+    }
+    EnableSharedFromThis& operator=(const EnableSharedFromThis&) noexcept {
+        return *this;
+    }
+
+private:
+    T* self_ = nullptr;
+    ControlBlock* block_ = nullptr;
+};
+
+class CompactESFTBase {};
+
+// `EnableSharedFromThis` that adds nothing to the object and costs nothing at creation:
+// `MakeShared` places the control block right before the object, where it is found from `this`.
+// `T` has to be created by `MakeShared<T>` itself, not as a part of a derived type, and cannot
+// be adopted from a raw pointer (both are compile-time errors). Calling `SharedFromThis` on
+// a `T` that does not live in a `SharedPtr`, e.g. on the stack, is undefined behaviour.
+template <typename T>
+class EnableSharedFromThisCompact : public CompactESFTBase {
+public:
+    SharedPtr<T> SharedFromThis() {
+        SharedPtr<T> result = TrySharedFromThis();
+        if (!result) {
+            throw BadWeakPtr();
+        }
+        return result;
+    };
+    SharedPtr<const T> SharedFromThis() const {
+        SharedPtr<const T> result = TrySharedFromThis();
+        if (!result) {
+            throw BadWeakPtr();
+        }
+        return result;
+    };
+    // Empty during destruction of the object
+    SharedPtr<T> TrySharedFromThis() noexcept {
+        if (!Block()->TryIncrementStrong()) {
+            return SharedPtr<T>();
+        }
+        return SharedPtr<T>(Block(), static_cast<T*>(this));
+    };
+    SharedPtr<const T> TrySharedFromThis() const noexcept {
+        if (!Block()->TryIncrementStrong()) {
+            return SharedPtr<const T>();
+        }
+        return SharedPtr<const T>(Block(), static_cast<const T*>(this));
+    };
+
+    WeakPtr<T> WeakFromThis() noexcept {
+        return WeakPtr<T>(Block(), static_cast<T*>(this));
+    };
+    WeakPtr<const T> WeakFromThis() const noexcept {
+        return WeakPtr<const T>(Block(), static_cast<const T*>(this));
+    };
+
+private:
+    ControlBlockBeforeObject<T>* Block() const noexcept {
+        return ControlBlockBeforeObject<T>::FromObject(static_cast<const T*>(this));
+    }
 };
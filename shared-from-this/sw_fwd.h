@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>  // size_t
 #include <exception>
+#include <new>  // std::launder
 
 class BadWeakPtr : public std::exception {};
 
@@ -9,26 +11,58 @@ public:
     virtual void IncrementWeak() = 0;
     virtual void DecrementWeak() = 0;
     virtual void IncrementStrong() = 0;
+    // Adds `count` strong references at once
+    virtual void AddStrong(size_t count) = 0;
+    // Adds a strong reference unless the object is already gone, in one step
+    virtual bool TryIncrementStrong() = 0;
     virtual void DecrementStrong() = 0;
     virtual size_t UseStrongCount() = 0;
     virtual size_t UseWeakCount() = 0;
     virtual ~ControlBlock() = default;
     virtual void DeleteObject() = 0;
+
+    // `MakeImmortalShared` biases the strong count past anything a program reaches. The blocks
+    // it makes stop counting above the bias, like `RefCounted::IsImmortal`, and report
+    // `kImmortalUseCount`: an immortal object is always shared, never unique.
+    static constexpr size_t kImmortalRefCount = size_t{1} << (sizeof(size_t) * 8 - 2);
+    static constexpr size_t kImmortalUseCount = 2;
 };
 
 template <typename T>
 class ControlBlockWithObject : public ControlBlock {
 public:
     size_t UseStrongCount() override {
-        return strong_counter_;
+        return strong_counter_ < kImmortalRefCount ? strong_counter_ : kImmortalUseCount;
     }
     size_t UseWeakCount() override {
         return weak_counter_;
     }
     void IncrementStrong() override {
+        if (strong_counter_ >= kImmortalRefCount) [[unlikely]] {
+            return;
+        }
         ++strong_counter_;
     }
+    void AddStrong(size_t count) override {
+        if (strong_counter_ >= kImmortalRefCount) [[unlikely]] {
+            return;
+        }
+        strong_counter_ += count;
+    }
+    bool TryIncrementStrong() override {
+        if (strong_counter_ == 0) {
+            return false;
+        }
+        if (strong_counter_ >= kImmortalRefCount) [[unlikely]] {
+            return true;
+        }
+        ++strong_counter_;
+        return true;
+    }
     void DecrementStrong() override {
+        if (strong_counter_ >= kImmortalRefCount) [[unlikely]] {
+            return;
+        }
         --strong_counter_;
     }
     void DeleteObject() override {
@@ -71,6 +105,16 @@ public:
     void IncrementStrong() override {
         ++strong_counter_;
     }
+    void AddStrong(size_t count) override {
+        strong_counter_ += count;
+    }
+    bool TryIncrementStrong() override {
+        if (strong_counter_ == 0) {
+            return false;
+        }
+        ++strong_counter_;
+        return true;
+    }
     void DecrementStrong() override {
         --strong_counter_;
     }
@@ -96,6 +140,94 @@ private:
     T* object_;
 };
 
+// Control block that sits right before the object it owns, in the same allocation.
+// The distance between them is a compile-time constant, so the block can be found
+// from the object alone (see `EnableSharedFromThisCompact`).
+template <typename T>
+class ControlBlockBeforeObject : public ControlBlock {
+public:
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+    template <typename... Args>
+    static ControlBlockBeforeObject* Create(Args&&... args) {
+        void* memory = ::operator new(ObjectOffset() + sizeof(T));
+        ControlBlockBeforeObject* block = ::new (memory) ControlBlockBeforeObject();
+        try {
+            ::new (static_cast<void*>(block->Get())) T(std::forward<Args>(args)...);
+        } catch (...) {
+            block->~ControlBlockBeforeObject();
+            ::operator delete(memory);
+            throw;
+        }
+        return block;
+    }
+    static ControlBlockBeforeObject* FromObject(const T* object) noexcept {
+        const char* memory = reinterpret_cast<const char*>(object) - ObjectOffset();
+        return std::launder(reinterpret_cast<ControlBlockBeforeObject*>(const_cast<char*>(memory)));
+    }
+    // Memory comes from `Create`, with the object after the block
+    static void operator delete(void* memory) {
+        ::operator delete(memory);
+    }
+
+    size_t UseStrongCount() override {
+        return strong_counter_ < kImmortalRefCount ? strong_counter_ : kImmortalUseCount;
+    }
+    size_t UseWeakCount() override {
+        return weak_counter_;
+    }
+    void IncrementStrong() override {
+        if (strong_counter_ >= kImmortalRefCount) [[unlikely]] {
+            return;
+        }
+        ++strong_counter_;
+    }
+    void AddStrong(size_t count) override {
+        if (strong_counter_ >= kImmortalRefCount) [[unlikely]] {
+            return;
+        }
+        strong_counter_ += count;
+    }
+    bool TryIncrementStrong() override {
+        if (strong_counter_ == 0) {
+            return false;
+        }
+        if (strong_counter_ >= kImmortalRefCount) [[unlikely]] {
+            return true;
+        }
+        ++strong_counter_;
+        return true;
+    }
+    void DecrementStrong() override {
+        if (strong_counter_ >= kImmortalRefCount) [[unlikely]] {
+            return;
+        }
+        --strong_counter_;
+    }
+    void DeleteObject() override {
+        Get()->~T();
+    }
+    void IncrementWeak() override {
+        ++weak_counter_;
+    }
+    void DecrementWeak() override {
+        --weak_counter_;
+    }
+    T* Get() noexcept {
+        return std::launder(reinterpret_cast<T*>(reinterpret_cast<char*>(this) + ObjectOffset()));
+    }
+
+private:
+    ControlBlockBeforeObject() = default;
+
+    static constexpr size_t ObjectOffset() noexcept {
+        return (sizeof(ControlBlockBeforeObject) + alignof(T) - 1) / alignof(T) * alignof(T);
+    }
+
+    size_t strong_counter_ = 1;
+    size_t weak_counter_ = 0;
+};
+
 template <typename T>
 class SharedPtr;
 
@@ -104,5 +236,9 @@ class WeakPtr;
 
 class ESFTBase;
 
+class CompactESFTBase;
+
+template <typename T>
+class EnableSharedFromThis;
 template <typename T>
-class EnableSharedFromThis;
\ No newline at end of file
+class EnableSharedFromThisCompact;
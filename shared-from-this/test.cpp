@@ -89,3 +89,177 @@ TEST_CASE("WeakFromThis") {
     REQUIRE(!weak.Expired());
     REQUIRE(weak.Lock().Get() == ptr);
 }
+
+TEST_CASE("TrySharedFromThis") {
+    T* ptr = new T;
+    const T* cptr = ptr;
+
+    static_assert(noexcept(ptr->TrySharedFromThis()), "Operation must be noexcept");
+    REQUIRE(!ptr->TrySharedFromThis());
+    REQUIRE_THROWS_AS(ptr->SharedFromThis(), BadWeakPtr);
+
+    SharedPtr<T> sptr(ptr);
+    SharedPtr<T> shared = ptr->TrySharedFromThis();
+    SharedPtr<const T> const_shared = cptr->TrySharedFromThis();
+
+    REQUIRE(shared == sptr);
+    REQUIRE(const_shared.Get() == ptr);
+    REQUIRE(sptr.UseCount() == 3);
+}
+
+TEST_CASE("WeakFromThis in the destructor") {
+    struct Probe : EnableSharedFromThis<Probe> {
+        ~Probe() {
+            *expired = WeakFromThis().Expired();
+        }
+        bool* expired;
+    };
+    bool expired = false;
+
+    SECTION("Adopted") {
+        SharedPtr<Probe> probe(new Probe);
+        probe->expired = &expired;
+        probe.Reset();
+        REQUIRE(expired);
+    }
+
+    SECTION("MakeShared") {
+        auto probe = MakeShared<Probe>();
+        probe->expired = &expired;
+        probe = SharedPtr<Probe>();
+        REQUIRE(expired);
+    }
+}
+
+TEST_CASE("SharedFromThis after promotion") {
+    SECTION("MakeUniqueShareable") {
+        auto up = MakeUniqueShareable<T>();
+        REQUIRE(!up->TrySharedFromThis());
+
+        SharedPtr<T> sp(std::move(up));
+        REQUIRE(sp->SharedFromThis() == sp);
+        REQUIRE(sp.UseCount() == 1);
+    }
+
+    SECTION("UniquePtr with a deleter") {
+        struct FlagDelete {
+            void operator()(T* ptr) {
+                if (ptr != nullptr) {
+                    *deleted = true;
+                    delete ptr;
+                }
+            }
+
+            bool* deleted = nullptr;
+        };
+        bool deleted = false;
+        {
+            UniquePtr<T, FlagDelete> up(new T, FlagDelete{&deleted});
+            SharedPtr<T> sp(std::move(up));
+            REQUIRE(sp->SharedFromThis() == sp);
+            REQUIRE(sp.UseCount() == 1);
+        }
+        REQUIRE(deleted);
+    }
+}
+
+struct Session final : EnableSharedFromThisCompact<Session> {
+    explicit Session(int id) : id(id) {
+    }
+
+    int id;
+};
+
+struct RegularSession : EnableSharedFromThis<RegularSession> {
+    int id;
+};
+
+TEST_CASE("EnableSharedFromThisCompact") {
+    static_assert(sizeof(Session) == sizeof(int));
+    static_assert(sizeof(RegularSession) > sizeof(Session));
+
+    SECTION("SharedFromThis") {
+        auto session = MakeShared<Session>(7);
+        const Session* csession = session.Get();
+
+        SharedPtr<Session> self = session->SharedFromThis();
+        SharedPtr<const Session> const_self = csession->SharedFromThis();
+
+        REQUIRE(self == session);
+        REQUIRE(const_self->id == 7);
+        REQUIRE(session.UseCount() == 3);
+    }
+
+    SECTION("WeakFromThis") {
+        WeakPtr<Session> weak;
+        {
+            auto session = MakeShared<Session>(1);
+            weak = session->WeakFromThis();
+
+            REQUIRE(!weak.Expired());
+            REQUIRE(weak.Lock() == session);
+        }
+        REQUIRE(weak.Expired());
+        REQUIRE(!weak.Lock());
+    }
+
+    SECTION("Inside the destructor") {
+        struct Probe final : EnableSharedFromThisCompact<Probe> {
+            ~Probe() {
+                *locked = static_cast<bool>(TrySharedFromThis());
+            }
+            bool* locked;
+        };
+        bool locked = true;
+        auto probe = MakeShared<Probe>();
+        probe->locked = &locked;
+        probe.Reset();
+
+        REQUIRE_FALSE(locked);
+    }
+
+    SECTION("WeakFromThis inside the destructor") {
+        struct Probe final : EnableSharedFromThisCompact<Probe> {
+            ~Probe() {
+                *expired = WeakFromThis().Expired();
+            }
+            bool* expired;
+        };
+        bool expired = false;
+        auto probe = MakeShared<Probe>();
+        probe->expired = &expired;
+        probe.Reset();
+
+        REQUIRE(expired);
+    }
+}
+
+TEST_CASE("Immortal objects with EnableSharedFromThis") {
+    static const SharedPtr<T> kRegular = MakeImmortalShared<T>();
+    static const SharedPtr<Session> kCompact = MakeImmortalShared<Session>(0);
+
+    REQUIRE(kRegular->SharedFromThis() == kRegular);
+    REQUIRE(kCompact->SharedFromThis() == kCompact);
+    REQUIRE(!kCompact->WeakFromThis().Expired());
+}
+
+TEST_CASE("No counter updates at construction") {
+    auto made = MakeShared<T>();
+    SharedPtr<T> adopted(new T);
+
+    REQUIRE(made.UseCount() == 1);
+    REQUIRE(made->WeakFromThis().UseCount() == 1);
+    REQUIRE(adopted->SharedFromThis().UseCount() == 2);
+
+    WeakPtr<T> weak = made->WeakFromThis();
+    made.Reset();
+    REQUIRE(weak.Expired());
+}
+
+TEST_CASE("Copies are not owned") {
+    auto original = MakeShared<T>();
+    T copy = *original;
+
+    REQUIRE(!copy.TrySharedFromThis());
+    REQUIRE(copy.WeakFromThis().Expired());
+}
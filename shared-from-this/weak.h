@@ -2,6 +2,8 @@
 
 #include "sw_fwd.h"  // Forward declaration
 
+#include <common/trivially_relocatable.h>
+
 // https://en.cppreference.com/w/cpp/memory/weak_ptr
 template <typename T>
 class WeakPtr {
@@ -10,6 +12,8 @@ public:
     friend class SharedPtr;
     template <typename Y>
     friend class WeakPtr;
+    template <typename Y>
+    friend class EnableSharedFromThis;
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Constructors
 
@@ -46,6 +50,14 @@ public:
         other.Reset();
     };
 
+    // Adds a weak reference to `block`
+    template <typename Y>
+    WeakPtr(ControlBlockBeforeObject<Y>* block, T* ptr) noexcept {
+        object_ptr_ = ptr;
+        block_ = block;
+        block_->IncrementWeak();
+    };
+
     // Demote `SharedPtr`
     // #2 from https://en.cppreference.com/w/cpp/memory/weak_ptr/weak_ptr
     template <typename Y>
@@ -134,10 +146,17 @@ public:
         return true;
     };
     SharedPtr<T> Lock() const noexcept {
-        if (this->Expired()) {
-            return SharedPtr<T>();
+        return TryLock();
+    };
+    // Empty if the object is gone. Checks and increments the counter in one step
+    // and never throws, unlike `SharedPtr(const WeakPtr&)`.
+    SharedPtr<T> TryLock() const noexcept {
+        SharedPtr<T> result;
+        if (block_ != nullptr && block_->TryIncrementStrong()) {
+            result.object_ptr_ = object_ptr_;
+            result.block_ = block_;
         }
-        return SharedPtr(*this);
+        return result;
     };
 
     void IncBlockStrong() {
@@ -148,3 +167,6 @@ private:
     T* object_ptr_;
     ControlBlock* block_;
 };
+
+template <typename T>
+struct IsTriviallyRelocatable<WeakPtr<T>> : std::true_type {};
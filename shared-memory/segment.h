@@ -0,0 +1,210 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>  // size_t, std::max_align_t
+#include <cstdint>  // uint64_t
+#include <new>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+// Memory shared by processes on one host: an anonymous `memfd` mapped with `MAP_SHARED`.
+// Another process maps the same memory with `Open` on a copy of the descriptor (inherited
+// over `fork` or passed over a unix socket); the mapping address differs between processes,
+// so everything inside the segment refers to other parts of it by offset from its start.
+//
+// The segment starts with a header that holds a first-fit allocator: freed chunks go to
+// a free list and are reused, there is no coalescing. The allocator lock is a spinlock in
+// the segment, so a process that dies while allocating leaves the segment locked.
+class SharedMemorySegment {
+public:
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    // Creates a new segment of `size` bytes, the header included
+    static SharedMemorySegment Create(size_t size) {
+        int fd = ::memfd_create("shared-memory-segment", MFD_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "memfd_create");
+        }
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "ftruncate");
+        }
+        SharedMemorySegment segment(fd, size);
+        ::new (segment.base_) Header{kMagic, size, {0}, AlignUp(sizeof(Header)), 0, 0};
+        return segment;
+    };
+    // Maps a segment created by another process, takes ownership of `fd`
+    static SharedMemorySegment Open(int fd) {
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "fstat");
+        }
+        SharedMemorySegment segment(fd, static_cast<size_t>(info.st_size));
+        if (segment.GetHeader()->magic != kMagic) {
+            throw std::system_error(EINVAL, std::generic_category(), "not a shared memory segment");
+        }
+        return segment;
+    };
+
+    SharedMemorySegment(SharedMemorySegment&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1)),
+          size_(std::exchange(other.size_, 0)),
+          base_(std::exchange(other.base_, nullptr)) {
+    }
+    SharedMemorySegment& operator=(SharedMemorySegment&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        Unmap();
+        fd_ = std::exchange(other.fd_, -1);
+        size_ = std::exchange(other.size_, 0);
+        base_ = std::exchange(other.base_, nullptr);
+        return *this;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Destructor
+
+    // Unmaps the segment in this process, the memory lives while any process maps it
+    ~SharedMemorySegment() {
+        Unmap();
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Allocation
+
+    // Aligned to `std::max_align_t`. Throws `std::bad_alloc` if the segment is full.
+    void* Allocate(size_t size) {
+        size_t need = AlignUp(size);
+        Header* header = GetHeader();
+        LockGuard guard(header->lock);
+
+        uint64_t* link = &header->free_list;
+        while (*link != 0) {
+            Chunk* chunk = ChunkAt(*link);
+            if (chunk->size >= need) {
+                uint64_t offset = std::exchange(*link, chunk->next_free);
+                header->used += chunk->size;
+                return base_ + offset + sizeof(Chunk);
+            }
+            link = &chunk->next_free;
+        }
+
+        if (header->bump + sizeof(Chunk) + need > size_) {
+            throw std::bad_alloc();
+        }
+        uint64_t offset = header->bump;
+        header->bump += sizeof(Chunk) + need;
+        header->used += need;
+        ::new (base_ + offset) Chunk{need, 0};
+        return base_ + offset + sizeof(Chunk);
+    };
+    // Any process may free memory allocated by another one
+    void Deallocate(void* ptr) noexcept {
+        uint64_t offset = ToOffset(ptr) - sizeof(Chunk);
+        Header* header = GetHeader();
+        LockGuard guard(header->lock);
+
+        Chunk* chunk = ChunkAt(offset);
+        header->used -= chunk->size;
+        chunk->next_free = std::exchange(header->free_list, offset);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    // Offsets are the same in every process, addresses are not
+    uint64_t ToOffset(const void* ptr) const noexcept {
+        return static_cast<uint64_t>(static_cast<const char*>(ptr) - base_);
+    };
+    void* FromOffset(uint64_t offset) const noexcept {
+        return base_ + offset;
+    };
+    int Fd() const noexcept {
+        return fd_;
+    };
+    size_t Size() const noexcept {
+        return size_;
+    };
+    // Bytes handed out by `Allocate` and not freed yet, in all processes
+    size_t Used() const noexcept {
+        return GetHeader()->used;
+    };
+
+private:
+    static constexpr uint64_t kMagic = 0x5348'4d53'4547'4d31;  // "SHMSEGM1"
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free,
+                  "Only lock-free atomics work across processes");
+
+    struct Header {
+        uint64_t magic;
+        uint64_t size;
+        std::atomic<uint32_t> lock;
+        uint64_t bump;
+        uint64_t free_list;
+        uint64_t used;
+    };
+    struct alignas(std::max_align_t) Chunk {
+        uint64_t size;
+        uint64_t next_free;
+    };
+
+    class LockGuard {
+    public:
+        explicit LockGuard(std::atomic<uint32_t>& lock) noexcept : lock_(lock) {
+            while (lock_.exchange(1, std::memory_order_acquire) != 0) {
+                std::this_thread::yield();
+            }
+        }
+        ~LockGuard() {
+            lock_.store(0, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<uint32_t>& lock_;
+    };
+
+    SharedMemorySegment(int fd, size_t size) : fd_(fd), size_(size) {
+        void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "mmap");
+        }
+        base_ = static_cast<char*>(base);
+    }
+
+    static constexpr size_t AlignUp(size_t size) noexcept {
+        constexpr size_t kAlign = alignof(std::max_align_t);
+        return (size + kAlign - 1) / kAlign * kAlign;
+    }
+
+    Header* GetHeader() const noexcept {
+        return std::launder(reinterpret_cast<Header*>(base_));
+    }
+    Chunk* ChunkAt(uint64_t offset) const noexcept {
+        return std::launder(reinterpret_cast<Chunk*>(base_ + offset));
+    }
+
+    void Unmap() noexcept {
+        if (base_ != nullptr) {
+            ::munmap(base_, size_);
+            ::close(fd_);
+        }
+    }
+
+    int fd_ = -1;
+    size_t size_ = 0;
+    char* base_ = nullptr;
+};
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "segment.h"
+
+#include <atomic>
+#include <cstddef>  // std::nullptr_t
+#include <cstdint>  // uint64_t
+#include <new>
+#include <utility>
+
+// Control block and object in one chunk of a `SharedMemorySegment`.
+// The counter is shared by all processes that map the segment.
+template <typename T>
+struct ShmControlBlock {
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                  "Only lock-free atomics work across processes");
+
+    template <typename... Args>
+    explicit ShmControlBlock(Args&&... args) {
+        ::new (static_cast<void*>(&object)) T(std::forward<Args>(args)...);
+    }
+
+    T* Get() noexcept {
+        return std::launder(reinterpret_cast<T*>(&object));
+    }
+
+    std::atomic<uint64_t> strong{1};
+    alignas(T) unsigned char object[sizeof(T)];
+};
+
+// `SharedPtr` to an object in a `SharedMemorySegment`, counted across processes: the object
+// is destroyed and its memory reused when the last reference in any process is released.
+// `T` is placed in memory mapped at different addresses, so it must not hold pointers;
+// plain data, offsets into the segment and `RelativePtr`-s inside the object are fine.
+// A `ShmSharedPtr` itself lives in process memory. To hand a reference to another process,
+// send the offset from `Share` or `Release`, and take it over there with `Adopt`.
+template <typename T>
+class ShmSharedPtr {
+public:
+    template <typename U, typename... Args>
+    friend ShmSharedPtr<U> MakeShmShared(SharedMemorySegment& segment, Args&&... args);
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    ShmSharedPtr() noexcept = default;
+    ShmSharedPtr(std::nullptr_t) noexcept {
+    }
+
+    ShmSharedPtr(const ShmSharedPtr& other) noexcept
+        : segment_(other.segment_), block_(other.block_) {
+        if (block_ != nullptr) {
+            block_->strong.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+    ShmSharedPtr(ShmSharedPtr&& other) noexcept
+        : segment_(std::exchange(other.segment_, nullptr)),
+          block_(std::exchange(other.block_, nullptr)) {
+    }
+
+    // Takes over a reference exported by `Share` or `Release` in this or another process
+    static ShmSharedPtr Adopt(SharedMemorySegment& segment, uint64_t offset) noexcept {
+        ShmSharedPtr result;
+        result.segment_ = &segment;
+        result.block_ = static_cast<ShmControlBlock<T>*>(segment.FromOffset(offset));
+        return result;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // `operator=`-s
+
+    ShmSharedPtr& operator=(const ShmSharedPtr& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        ShmSharedPtr copy(other);
+        this->Swap(copy);
+        return *this;
+    };
+    ShmSharedPtr& operator=(ShmSharedPtr&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        ShmSharedPtr tmp(std::move(other));
+        this->Swap(tmp);
+        return *this;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Destructor
+
+    ~ShmSharedPtr() {
+        Reset();
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Modifiers
+
+    void Reset() noexcept {
+        if (block_ == nullptr) {
+            return;
+        }
+        ShmControlBlock<T>* block = std::exchange(block_, nullptr);
+        SharedMemorySegment* segment = std::exchange(segment_, nullptr);
+        if (block->strong.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            block->Get()->~T();
+            block->~ShmControlBlock<T>();
+            segment->Deallocate(block);
+        }
+    };
+    void Swap(ShmSharedPtr& other) noexcept {
+        std::swap(segment_, other.segment_);
+        std::swap(block_, other.block_);
+    };
+    // Adds a reference for another process, it must be taken over there with `Adopt`
+    uint64_t Share() const noexcept {
+        block_->strong.fetch_add(1, std::memory_order_relaxed);
+        return segment_->ToOffset(block_);
+    };
+    // Gives the reference of this pointer away, it must be taken over with `Adopt`
+    uint64_t Release() noexcept {
+        uint64_t offset = segment_->ToOffset(block_);
+        block_ = nullptr;
+        segment_ = nullptr;
+        return offset;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    T* Get() const noexcept {
+        return block_ != nullptr ? block_->Get() : nullptr;
+    };
+    T& operator*() const noexcept {
+        return *Get();
+    };
+    T* operator->() const noexcept {
+        return Get();
+    };
+    // References in all processes, a snapshot
+    size_t UseCount() const noexcept {
+        return block_ != nullptr ? block_->strong.load(std::memory_order_relaxed) : 0;
+    };
+    explicit operator bool() const noexcept {
+        return block_ != nullptr;
+    };
+
+private:
+    SharedMemorySegment* segment_ = nullptr;
+    ShmControlBlock<T>* block_ = nullptr;
+};
+
+// Allocate memory only once, in `segment`
+template <typename T, typename... Args>
+ShmSharedPtr<T> MakeShmShared(SharedMemorySegment& segment, Args&&... args) {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned types are not supported");
+    void* memory = segment.Allocate(sizeof(ShmControlBlock<T>));
+    ShmSharedPtr<T> result;
+    try {
+        result.block_ = ::new (memory) ShmControlBlock<T>(std::forward<Args>(args)...);
+    } catch (...) {
+        segment.Deallocate(memory);
+        throw;
+    }
+    result.segment_ = &segment;
+    return result;
+};
@@ -0,0 +1,125 @@
+#include "shm_shared.h"
+
+#include <catch.hpp>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <system_error>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Table {
+    explicit Table(int seed) {
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = seed + static_cast<int>(i);
+        }
+    }
+    ~Table() {
+        ++destroyed;
+    }
+
+    static inline int destroyed = 0;
+
+    std::array<int, 256> values;
+};
+
+// Runs `child` in a forked process that maps the segment anew, returns its exit code
+int RunInChild(const SharedMemorySegment& segment,
+               const std::function<bool(SharedMemorySegment&)>& child) {
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        auto mapped = SharedMemorySegment::Open(::dup(segment.Fd()));
+        ::_exit(child(mapped) ? 0 : 1);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+TEST_CASE("SharedMemorySegment") {
+    SECTION("Allocate and reuse") {
+        auto segment = SharedMemorySegment::Create(1 << 16);
+        void* a = segment.Allocate(100);
+        void* b = segment.Allocate(1);
+
+        REQUIRE(reinterpret_cast<uintptr_t>(a) % alignof(std::max_align_t) == 0);
+        REQUIRE(reinterpret_cast<uintptr_t>(b) % alignof(std::max_align_t) == 0);
+        REQUIRE(segment.Used() >= 101);
+
+        segment.Deallocate(a);
+        REQUIRE(segment.Allocate(64) == a);
+        segment.Deallocate(a);
+        segment.Deallocate(b);
+        REQUIRE(segment.Used() == 0);
+    }
+
+    SECTION("Full segment") {
+        auto segment = SharedMemorySegment::Create(4096);
+        REQUIRE_THROWS_AS(segment.Allocate(8192), std::bad_alloc);
+    }
+
+    SECTION("Not a segment") {
+        int fd = ::memfd_create("not-a-segment", MFD_CLOEXEC);
+        REQUIRE(::ftruncate(fd, 4096) == 0);
+        REQUIRE_THROWS_AS(SharedMemorySegment::Open(fd), std::system_error);
+    }
+}
+
+TEST_CASE("ShmSharedPtr") {
+    auto segment = SharedMemorySegment::Create(1 << 20);
+    Table::destroyed = 0;
+
+    SECTION("In one process") {
+        auto table = MakeShmShared<Table>(segment, 10);
+        auto copy = table;
+
+        REQUIRE(copy->values[5] == 15);
+        REQUIRE(table.UseCount() == 2);
+
+        table.Reset();
+        copy.Reset();
+        REQUIRE(Table::destroyed == 1);
+        REQUIRE(segment.Used() == 0);
+    }
+
+    SECTION("Share and adopt") {
+        auto table = MakeShmShared<Table>(segment, 0);
+        auto adopted = ShmSharedPtr<Table>::Adopt(segment, table.Share());
+        auto released = ShmSharedPtr<Table>::Adopt(segment, adopted.Release());
+
+        REQUIRE(!adopted);
+        REQUIRE(released.Get() == table.Get());
+        REQUIRE(table.UseCount() == 2);
+    }
+
+    SECTION("Another process reads and releases") {
+        auto table = MakeShmShared<Table>(segment, 100);
+        uint64_t offset = table.Share();
+
+        int code = RunInChild(segment, [offset](SharedMemorySegment& mapped) {
+            auto view = ShmSharedPtr<Table>::Adopt(mapped, offset);
+            return view->values[255] == 355 && view.UseCount() == 2;
+        });
+
+        REQUIRE(code == 0);
+        REQUIRE(table.UseCount() == 1);
+    }
+
+    SECTION("The last release in another process reclaims") {
+        uint64_t offset = MakeShmShared<Table>(segment, 1).Release();
+        REQUIRE(segment.Used() > 0);
+
+        int code = RunInChild(segment, [offset](SharedMemorySegment& mapped) {
+            ShmSharedPtr<Table>::Adopt(mapped, offset).Reset();
+            return Table::destroyed == 1;
+        });
+
+        REQUIRE(code == 0);
+        REQUIRE(segment.Used() == 0);
+    }
+}
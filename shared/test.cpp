@@ -4,7 +4,10 @@
 
 #include "allocations_checker.h"
 
+#include <iterator>
 #include <memory>
+#include <string>
+#include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -467,3 +470,358 @@ TEST_CASE("Destructor for correct type") {
         REQUIRE(B::destructor_called);
     }
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct CountingDelete {
+    void operator()(int* ptr) {
+        if (ptr != nullptr) {
+            delete ptr;
+            ++*calls;
+        }
+    }
+
+    int* calls = nullptr;
+};
+
+TEST_CASE("From UniquePtr") {
+    SECTION("Default deleter") {
+        UniquePtr<int> up(new int(42));
+        int* p = up.Get();
+        SharedPtr<int> sp(std::move(up));
+
+        REQUIRE(!up);
+        REQUIRE(sp.Get() == p);
+        REQUIRE(sp.UseCount() == 1);
+    }
+
+    SECTION("Deleter is kept") {
+        int calls = 0;
+        {
+            UniquePtr<int, CountingDelete> up(new int(1), CountingDelete{&calls});
+            SharedPtr<int> sp(std::move(up));
+            SharedPtr<int> sp2 = sp;
+        }
+        REQUIRE(calls == 1);
+    }
+
+    SECTION("Empty") {
+        UniquePtr<int> up;
+        SharedPtr<int> sp(std::move(up));
+
+        REQUIRE(!sp);
+        REQUIRE(sp.UseCount() == 0);
+    }
+
+    SECTION("Destructor for correct type") {
+        B::destructor_called = false;
+        {
+            UniquePtr<B> up(new B);
+            SharedPtr<A> sp(std::move(up));
+        }
+        REQUIRE(B::destructor_called);
+    }
+}
+
+TEST_CASE("MakeUniqueShareable") {
+    SECTION("One allocation") {
+        EXPECT_ONE_ALLOCATION(REQUIRE(*MakeUniqueShareable<int>(42) == 42));
+    }
+
+    SECTION("Promotion does not allocate") {
+        auto up = MakeUniqueShareable<std::string>("shared later");
+        std::string* p = up.Get();
+        SharedPtr<std::string> sp;
+        EXPECT_ZERO_ALLOCATIONS(sp = SharedPtr<std::string>(std::move(up)));
+
+        REQUIRE(!up);
+        REQUIRE(sp.Get() == p);
+        REQUIRE(*sp == "shared later");
+        REQUIRE(sp.UseCount() == 1);
+
+        SharedPtr<std::string> sp2 = sp;
+        REQUIRE(sp.UseCount() == 2);
+    }
+
+    SECTION("Never shared") {
+        B::destructor_called = false;
+        { auto up = MakeUniqueShareable<B>(); }
+        REQUIRE(B::destructor_called);
+    }
+
+    SECTION("Upcast on promotion") {
+        B::destructor_called = false;
+        { SharedPtr<A> sp(MakeUniqueShareable<B>()); }
+        REQUIRE(B::destructor_called);
+    }
+
+    SECTION("Stays with its deleter") {
+        using Shareable = UniquePtr<int, ShareableDelete<int>>;
+        static_assert(!std::is_constructible_v<UniquePtr<int>, Shareable>);
+        static_assert(!std::is_assignable_v<UniquePtr<int>&, Shareable>);
+        static_assert(!std::is_constructible_v<UniquePtr<A, ShareableDelete<A>>,
+                                               UniquePtr<B, ShareableDelete<B>>>);
+    }
+}
+
+// Defined in test_incomplete.cpp
+struct Opaque;
+SharedPtr<Opaque> MakeOpaque();
+int OpaqueDestroyed();
+
+TEST_CASE("Lazy control block") {
+    SECTION("Only on request") {
+        static_assert(std::is_nothrow_copy_constructible_v<SharedPtr<std::string>>);
+        static_assert(std::is_nothrow_copy_assignable_v<SharedPtr<std::string>>);
+
+        SharedPtr<std::string> sp(new std::string("eager"));
+        SharedPtr<std::string> copy;
+        EXPECT_ZERO_ALLOCATIONS(copy = sp);
+        REQUIRE(sp.UseCount() == 2);
+    }
+
+    SECTION("Sole owner does not allocate") {
+        std::string* raw = new std::string("sole");
+        EXPECT_ZERO_ALLOCATIONS(auto sp = SharedPtr<std::string>::AdoptLazy(raw);
+                                REQUIRE(sp.UseCount() == 1));
+    }
+
+    SECTION("First copy allocates") {
+        auto sp = SharedPtr<std::string>::AdoptLazy(new std::string("copied"));
+        SharedPtr<std::string> copy;
+        EXPECT_ONE_ALLOCATION(copy = sp);
+        EXPECT_ZERO_ALLOCATIONS(SharedPtr<std::string> third(sp));
+
+        REQUIRE(sp.UseCount() == 2);
+        REQUIRE(copy.Get() == sp.Get());
+        sp.Reset();
+        REQUIRE(*copy == "copied");
+        REQUIRE(copy.UseCount() == 1);
+    }
+
+    SECTION("Moves keep the pointer sole") {
+        std::string* raw = new std::string("moved");
+        auto sp = SharedPtr<std::string>::AdoptLazy(raw);
+        EXPECT_ZERO_ALLOCATIONS(SharedPtr<std::string> moved(std::move(sp));
+                                SharedPtr<const std::string> moved_const(std::move(moved));
+                                REQUIRE(moved_const.Get() == raw));
+    }
+
+    SECTION("Assignment between sole owners") {
+        auto a = SharedPtr<std::string>::AdoptLazy(new std::string("a"));
+        auto b = SharedPtr<std::string>::AdoptLazy(new std::string("b"));
+        a = b;
+
+        REQUIRE(a.Get() == b.Get());
+        REQUIRE(a.UseCount() == 2);
+    }
+
+    SECTION("Non-virtual destructor still deletes the right type") {
+        B::destructor_called = false;
+        {
+            auto sb = SharedPtr<B>::AdoptLazy(new B);
+            SharedPtr<A> sa(std::move(sb));
+            SharedPtr<A> copy = sa;
+        }
+        REQUIRE(B::destructor_called);
+    }
+
+    SECTION("Virtual destructor stays lazy") {
+        Derived::i_was_deleted = false;
+        Derived* raw = new Derived;
+        EXPECT_ZERO_ALLOCATIONS(auto sb = SharedPtr<Base>::AdoptLazy(raw);
+                                REQUIRE(sb.UseCount() == 1));
+        REQUIRE(Derived::i_was_deleted);
+    }
+
+    SECTION("Incomplete type") {
+        int destroyed = OpaqueDestroyed();
+        {
+            SharedPtr<Opaque> sole = MakeOpaque();
+        }
+        REQUIRE(OpaqueDestroyed() == destroyed + 1);
+        {
+            SharedPtr<Opaque> sp = MakeOpaque();
+            SharedPtr<const Opaque> copy = sp;
+            sp.Reset();
+            REQUIRE(copy.UseCount() == 1);
+        }
+        REQUIRE(OpaqueDestroyed() == destroyed + 2);
+    }
+}
+
+TEST_CASE("ShareN") {
+    SECTION("Fan-out") {
+        auto sp = MakeShared<std::string>("message");
+        std::vector<SharedPtr<std::string>> subscribers;
+        subscribers.reserve(3);
+        EXPECT_ZERO_ALLOCATIONS(sp.ShareN(3, std::back_inserter(subscribers)));
+
+        REQUIRE(sp.UseCount() == 4);
+        for (const auto& s : subscribers) {
+            REQUIRE(s.Get() == sp.Get());
+        }
+        subscribers.pop_back();
+        REQUIRE(sp.UseCount() == 3);
+        sp.Reset();
+        REQUIRE(*subscribers[1] == "message");
+        REQUIRE(subscribers[1].UseCount() == 2);
+    }
+
+    SECTION("Into existing slots") {
+        SharedPtr<int> sp(new int(7));
+        std::vector<SharedPtr<int>> slots(4, MakeShared<int>(0));
+        auto end = sp.ShareN(slots.size(), slots.begin());
+
+        REQUIRE(end == slots.end());
+        REQUIRE(sp.UseCount() == 5);
+        REQUIRE(*slots[3] == 7);
+    }
+
+    SECTION("Empty") {
+        SharedPtr<int> sp;
+        std::vector<SharedPtr<int>> out;
+        sp.ShareN(2, std::back_inserter(out));
+
+        REQUIRE(out.size() == 2);
+        REQUIRE(!out[0]);
+        REQUIRE(out[1].UseCount() == 0);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Message {
+    enum Kind { kPing, kData };
+
+    explicit Message(Kind kind) : kind(kind) {
+    }
+    virtual ~Message() = default;
+
+    Kind kind;
+};
+
+struct Ping : Message {
+    Ping() : Message(kPing) {
+    }
+
+    static bool ClassOf(const Message* message) {
+        return message->kind == kPing;
+    }
+};
+
+struct DataMessage : Message {
+    DataMessage() : Message(kData) {
+    }
+
+    static bool ClassOf(const Message* message) {
+        return message->kind == kData;
+    }
+
+    int payload = 7;
+};
+
+TEST_CASE("Pointer casts") {
+    SECTION("Static") {
+        SharedPtr<Message> message = MakeShared<DataMessage>();
+        auto data = StaticPointerCast<DataMessage>(message);
+
+        REQUIRE(data->payload == 7);
+        REQUIRE(message.UseCount() == 2);
+
+        SharedPtr<DataMessage> moved;
+        EXPECT_ZERO_ALLOCATIONS(moved = StaticPointerCast<DataMessage>(std::move(message)));
+        REQUIRE(!message);
+        REQUIRE(moved.Get() == data.Get());
+        REQUIRE(moved.UseCount() == 2);
+    }
+
+    SECTION("Dynamic") {
+        SharedPtr<Message> message = MakeShared<DataMessage>();
+
+        REQUIRE(!DynamicPointerCast<Ping>(message));
+        REQUIRE(!DynamicPointerCast<Ping>(std::move(message)));
+        REQUIRE(message);
+        REQUIRE(message.UseCount() == 1);
+
+        auto data = DynamicPointerCast<DataMessage>(std::move(message));
+        REQUIRE(!message);
+        REQUIRE(data->payload == 7);
+        REQUIRE(data.UseCount() == 1);
+    }
+
+    SECTION("Const") {
+        SharedPtr<const int> value = MakeShared<int>(1);
+        auto copy = ConstPointerCast<int>(value);
+        *copy = 2;
+
+        REQUIRE(*value == 2);
+        auto moved = ConstPointerCast<int>(std::move(value));
+        REQUIRE(!value);
+        REQUIRE(moved.UseCount() == 2);
+    }
+
+    SECTION("Fast dynamic") {
+        SharedPtr<Message> message = MakeShared<Ping>();
+
+        REQUIRE(!FastDynamicPointerCast<DataMessage>(message));
+        REQUIRE(FastDynamicPointerCast<Ping>(message).UseCount() == 2);
+
+        auto ping = FastDynamicPointerCast<Ping>(std::move(message));
+        REQUIRE(!message);
+        REQUIRE(ping.UseCount() == 1);
+    }
+
+    SECTION("Sole owner stays without a control block") {
+        SharedPtr<Message> message(new DataMessage);
+        SharedPtr<DataMessage> data;
+
+        EXPECT_ZERO_ALLOCATIONS(data = StaticPointerCast<DataMessage>(std::move(message)));
+        REQUIRE(data.UseCount() == 1);
+    }
+
+    SECTION("Aliasing move") {
+        auto data = MakeShared<DataMessage>();
+        SharedPtr<int> payload(std::move(data), &data->payload);
+
+        REQUIRE(!data);
+        REQUIRE(*payload == 7);
+        REQUIRE(payload.UseCount() == 1);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Immortal objects") {
+    static const SharedPtr<std::string> kEmpty = MakeImmortalShared<std::string>("empty");
+
+    SECTION("Copies are not counted") {
+        REQUIRE(kEmpty.UseCount() == 2);
+        {
+            SharedPtr<std::string> a = kEmpty;
+            SharedPtr<const std::string> b(kEmpty);
+            SharedPtr<std::string> c;
+            c = a;
+            std::vector<SharedPtr<std::string>> copies;
+            kEmpty.ShareN(4, std::back_inserter(copies));
+
+            REQUIRE(kEmpty.UseCount() == 2);
+            REQUIRE(*c == "empty");
+            REQUIRE(*b == "empty");
+        }
+        REQUIRE(kEmpty.UseCount() == 2);
+    }
+
+    SECTION("The last pointer does not destroy the object") {
+        {
+            SharedPtr<std::string> copy = kEmpty;
+            copy.Reset();
+        }
+        SharedPtr<std::string> alias(kEmpty, kEmpty.Get());
+        REQUIRE(*alias == "empty");
+    }
+
+    SECTION("No allocations on copies") {
+        EXPECT_ZERO_ALLOCATIONS(SharedPtr<std::string>{kEmpty});
+    }
+}
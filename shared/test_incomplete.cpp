@@ -0,0 +1,20 @@
+#include "shared.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Complete only in this translation unit, see "Incomplete type" in test.cpp
+struct Opaque {
+    ~Opaque() {
+        ++destroyed;
+    }
+
+    static inline int destroyed = 0;
+};
+
+SharedPtr<Opaque> MakeOpaque() {
+    return SharedPtr<Opaque>::AdoptLazy(new Opaque);
+}
+
+int OpaqueDestroyed() {
+    return Opaque::destroyed;
+}
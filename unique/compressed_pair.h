@@ -10,28 +10,29 @@ template <typename F, typename S, bool = std::is_empty_v<F> && !std::is_final_v<
           bool = std::is_empty_v<S> && !std::is_final_v<S>, bool = std::is_same_v<F, S>>
 class CompressedPair {
 public:
-    CompressedPair() {
+    constexpr CompressedPair() {
         first_ = F();
         second_ = S();
     };
-    CompressedPair(F& first, S&& second) : first_(first), second_(std::move(second)) {
+    constexpr CompressedPair(F& first, S&& second) : first_(first), second_(std::move(second)) {
     }
-    CompressedPair(F&& first, S&& second) : first_(std::move(first)), second_(std::move(second)) {
+    constexpr CompressedPair(F&& first, S&& second)
+        : first_(std::move(first)), second_(std::move(second)) {
     }
 
-    F& GetFirst() {
+    constexpr F& GetFirst() {
         return first_;
     }
 
-    const F& GetFirst() const {
+    constexpr const F& GetFirst() const {
         return first_;
     }
 
-    S& GetSecond() {
+    constexpr S& GetSecond() {
         return second_;
     }
 
-    const S& GetSecond() const {
+    constexpr const S& GetSecond() const {
         return second_;
     };
 
@@ -42,38 +43,38 @@ private:
 
 template <typename F, typename S>
 class CompressedPair<F, S, true, true, false> : public F, public S {
-    auto GetFirst() {
+    constexpr F& GetFirst() {
         return *this;
     }
 
-    auto GetFirst() const {
+    constexpr const F& GetFirst() const {
         return *this;
     }
 
-    auto GetSecond() {
+    constexpr S& GetSecond() {
         return *this;
     }
 
-    auto GetSecond() const {
+    constexpr const S& GetSecond() const {
         return *this;
     };
 };
 
 template <typename F, typename S>
 class CompressedPair<F, S, true, true, true> : public F {
-    F& GetFirst() {
+    constexpr F& GetFirst() {
         return first_;
     }
 
-    const F& GetFirst() const {
+    constexpr const F& GetFirst() const {
         return first_;
     }
 
-    auto GetSecond() {
+    constexpr S& GetSecond() {
         return *this;
     }
 
-    auto GetSecond() const {
+    constexpr const S& GetSecond() const {
         return *this;
     };
 
@@ -84,27 +85,28 @@ private:
 template <typename F, typename S>
 class CompressedPair<F, S, true, false, true> : public F {
 public:
-    CompressedPair() {
+    constexpr CompressedPair() {
         second_ = S();
     };
-    CompressedPair(F& first, S&& second) : second_(std::move(second)) {
+    constexpr CompressedPair(F& first, S&& second) : F(first), second_(std::move(second)) {
     }
-    CompressedPair(F&& first, S&& second) : second_(std::move(second)) {
+    constexpr CompressedPair(F&& first, S&& second)
+        : F(std::move(first)), second_(std::move(second)) {
     }
 
-    auto GetFirst() {
+    constexpr F& GetFirst() {
         return *this;
     }
 
-    auto GetFirst() const {
+    constexpr const F& GetFirst() const {
         return *this;
     }
 
-    S& GetSecond() {
+    constexpr S& GetSecond() {
         return second_;
     }
 
-    const S& GetSecond() const {
+    constexpr const S& GetSecond() const {
         return second_;
     };
 
@@ -115,27 +117,28 @@ private:
 template <typename F, typename S>
 class CompressedPair<F, S, true, false, false> : public F {
 public:
-    CompressedPair() {
+    constexpr CompressedPair() {
         second_ = S();
     };
-    CompressedPair(F& first, S&& second) : second_(std::move(second)) {
+    constexpr CompressedPair(F& first, S&& second) : F(first), second_(std::move(second)) {
     }
-    CompressedPair(F&& first, S&& second) : second_(std::move(second)) {
+    constexpr CompressedPair(F&& first, S&& second)
+        : F(std::move(first)), second_(std::move(second)) {
     }
 
-    auto GetFirst() {
+    constexpr F& GetFirst() {
         return *this;
     }
 
-    auto GetFirst() const {
+    constexpr const F& GetFirst() const {
         return *this;
     }
 
-    S& GetSecond() {
+    constexpr S& GetSecond() {
         return second_;
     }
 
-    const S& GetSecond() const {
+    constexpr const S& GetSecond() const {
         return second_;
     };
 
@@ -146,27 +149,28 @@ private:
 template <typename F, typename S>
 class CompressedPair<F, S, false, true, true> : public S {
 public:
-    CompressedPair() {
+    constexpr CompressedPair() {
         first_ = F();
     };
-    CompressedPair(F& first, S&& second) : first_(first) {
+    constexpr CompressedPair(F& first, S&& second) : S(std::move(second)), first_(first) {
     }
-    CompressedPair(F&& first, S&& second) : first_(std::move(first)) {
+    constexpr CompressedPair(F&& first, S&& second)
+        : S(std::move(second)), first_(std::move(first)) {
     }
 
-    F& GetFirst() {
+    constexpr F& GetFirst() {
         return first_;
     }
 
-    const F& GetFirst() const {
+    constexpr const F& GetFirst() const {
         return first_;
     }
 
-    auto GetSecond() {
+    constexpr S& GetSecond() {
         return *this;
     }
 
-    auto GetSecond() const {
+    constexpr const S& GetSecond() const {
         return *this;
     };
 
@@ -177,27 +181,28 @@ private:
 template <typename F, typename S>
 class CompressedPair<F, S, false, true, false> : public S {
 public:
-    CompressedPair() {
+    constexpr CompressedPair() {
         first_ = F();
     };
-    CompressedPair(F& first, S&& second) : first_(first) {
+    constexpr CompressedPair(F& first, S&& second) : S(std::move(second)), first_(first) {
     }
-    CompressedPair(F&& first, S&& second) : first_(std::move(first)) {
+    constexpr CompressedPair(F&& first, S&& second)
+        : S(std::move(second)), first_(std::move(first)) {
     }
 
-    F& GetFirst() {
+    constexpr F& GetFirst() {
         return first_;
     }
 
-    const F& GetFirst() const {
+    constexpr const F& GetFirst() const {
         return first_;
     }
 
-    auto GetSecond() {
+    constexpr S& GetSecond() {
         return *this;
     }
 
-    auto GetSecond() const {
+    constexpr const S& GetSecond() const {
         return *this;
     };
 
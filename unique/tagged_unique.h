@@ -0,0 +1,132 @@
+#pragma once
+
+#include "unique.h"
+
+#include <common/tagged_word.h>
+#include <common/trivially_relocatable.h>
+
+#include <cstddef>  // std::nullptr_t
+#include <cstdint>  // uintptr_t
+#include <utility>
+
+// `UniquePtr` that keeps a small tag in the alignment bits of the pointer.
+// The tag travels with the pointer on moves and survives `Reset` and `Release`.
+template <typename T, typename Deleter = Slug<T>>
+class TaggedUniquePtr {
+public:
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    TaggedUniquePtr() noexcept = default;
+    explicit TaggedUniquePtr(T* ptr, uintptr_t tag = 0) noexcept {
+        pair_.GetFirst() = TaggedWord<T>(ptr, tag);
+    };
+    TaggedUniquePtr(T* ptr, uintptr_t tag, Deleter deleter) noexcept {
+        pair_.GetFirst() = TaggedWord<T>(ptr, tag);
+        pair_.GetSecond() = std::forward<Deleter>(deleter);
+    };
+
+    TaggedUniquePtr(TaggedUniquePtr&& other) noexcept {
+        this->Swap(other);
+        other.Reset();
+        other.SetTag(0);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // `operator=`-s
+
+    TaggedUniquePtr& operator=(TaggedUniquePtr&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        this->Swap(other);
+        other.Reset();
+        other.SetTag(0);
+        return *this;
+    };
+    TaggedUniquePtr& operator=(std::nullptr_t) noexcept {
+        this->Reset();
+        return *this;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Destructor
+
+    ~TaggedUniquePtr() {
+        T* ptr = Get();
+        if (ptr != nullptr) {
+            pair_.GetSecond()(ptr);
+        }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Modifiers
+
+    T* Release() noexcept {
+        T* ret = Get();
+        pair_.GetFirst().SetPointer(nullptr);
+        return ret;
+    };
+    void Reset(T* ptr = nullptr) noexcept {
+        T* el = Get();
+        pair_.GetFirst().SetPointer(ptr);
+        if (el != nullptr) {
+            pair_.GetSecond()(el);
+        }
+    };
+    void SetTag(uintptr_t tag) noexcept {
+        pair_.GetFirst().SetTag(tag);
+    };
+    void Swap(TaggedUniquePtr& other) noexcept {
+        std::swap(pair_, other.pair_);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    // Pointer with the tag bits cleared
+    T* Get() const noexcept {
+        return pair_.GetFirst().GetPointer();
+    };
+    uintptr_t GetTag() const noexcept {
+        return pair_.GetFirst().GetTag();
+    };
+    static constexpr size_t TagBits() noexcept {
+        return TaggedWord<T>::TagBits();
+    };
+    Deleter& GetDeleter() noexcept {
+        return pair_.GetSecond();
+    };
+    const Deleter& GetDeleter() const noexcept {
+        return pair_.GetSecond();
+    };
+    explicit operator bool() const noexcept {
+        return Get() != nullptr;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Single-object dereference operators
+
+    T& operator*() const noexcept {
+        return *Get();
+    };
+    T* operator->() const noexcept {
+        return Get();
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Comparisons take both the pointer and the tag into account
+
+    bool operator==(const TaggedUniquePtr& other) const noexcept {
+        return pair_.GetFirst() == other.pair_.GetFirst();
+    };
+    bool operator==(std::nullptr_t) const noexcept {
+        return Get() == nullptr;
+    };
+
+private:
+    CompressedPair<TaggedWord<T>, Deleter> pair_;
+};
+
+template <typename T, typename Deleter>
+struct IsTriviallyRelocatable<TaggedUniquePtr<T, Deleter>> : IsTriviallyRelocatable<Deleter> {};
@@ -6,6 +6,7 @@
 
 #include <catch.hpp>
 #include <vector>
+#include <string>
 #include <tuple>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -467,7 +468,10 @@ TEST_CASE("Compressed pair usage") {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 template <typename T>
-class DerivedDeleter : public Deleter<T> {};
+class DerivedDeleter : public Deleter<T> {
+public:
+    using Deleter<T>::Deleter;
+};
 
 TEST_CASE("Upcasts") {
     SECTION("Upcast ptr in move constructor") {
@@ -494,13 +498,86 @@ TEST_CASE("Upcasts") {
     }
 
     SECTION("Upcast deleter in move constructor") {
-        UniquePtr<MyInt, DerivedDeleter<MyInt>> s(new MyInt);
+        UniquePtr<MyInt, DerivedDeleter<MyInt>> s(new MyInt, DerivedDeleter<MyInt>(7));
         UniquePtr<MyInt, Deleter<MyInt>> s2(std::move(s));
+        REQUIRE(s2.GetDeleter().GetTag() == 7);
+        REQUIRE(s.GetDeleter().GetTag() == 0);
     }
 
     SECTION("Upcast deleter in move assignment") {
-        UniquePtr<MyInt, DerivedDeleter<MyInt>> s(new MyInt);
+        UniquePtr<MyInt, DerivedDeleter<MyInt>> s(new MyInt, DerivedDeleter<MyInt>(7));
         UniquePtr<MyInt, Deleter<MyInt>> s2(new MyInt);
         s2 = std::move(s);
+        REQUIRE(s2.GetDeleter().GetTag() == 7);
+    }
+
+    SECTION("Deleter that does not convert") {
+        static_assert(!std::is_constructible_v<UniquePtr<MyInt>, UniquePtr<MyInt, Deleter<MyInt>>>);
+        static_assert(!std::is_assignable_v<UniquePtr<MyInt>&, UniquePtr<MyInt, Deleter<MyInt>>>);
+        static_assert(
+            !std::is_constructible_v<UniquePtr<MyInt, Deleter<MyInt>>, UniquePtr<MyInt>>);
     }
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct BitTrieNode {
+    int value = 0;
+    UniquePtr<BitTrieNode> children[2];
+};
+
+constexpr void BitTrieInsert(UniquePtr<BitTrieNode>& node, int key, int depth) {
+    if (!node) {
+        node = MakeUnique<BitTrieNode>();
+    }
+    if (depth == 0) {
+        node->value = key;
+        return;
+    }
+    BitTrieInsert(node->children[(key >> (depth - 1)) & 1], key, depth - 1);
+}
+
+constexpr int BitTrieSum(const UniquePtr<BitTrieNode>& node) {
+    if (!node) {
+        return 0;
+    }
+    return node->value + BitTrieSum(node->children[0]) + BitTrieSum(node->children[1]);
+}
+
+constexpr int BuildAndSumBitTrie() {
+    UniquePtr<BitTrieNode> root;
+    for (int key = 0; key < 16; ++key) {
+        BitTrieInsert(root, key, 4);
+    }
+    return BitTrieSum(root);
+}
+
+constexpr int MoveAndReset() {
+    auto a = MakeUnique<int>(5);
+    UniquePtr<int> b = std::move(a);
+    int result = (a ? 100 : 0) + *b;
+    b.Reset(new int(7));
+    result += *b;
+    int* raw = b.Release();
+    result += *raw;
+    delete raw;
+    return result;
+}
+
+constexpr int ArraySum() {
+    auto array = MakeUnique<int[]>(4);
+    for (int i = 0; i < 4; ++i) {
+        array[i] = i + 1;
+    }
+    return array[0] + array[1] + array[2] + array[3];
+}
+
+TEST_CASE("Constant evaluation") {
+    static_assert(BuildAndSumBitTrie() == 120);
+    static_assert(MoveAndReset() == 19);
+    static_assert(ArraySum() == 10);
+
+    REQUIRE(BuildAndSumBitTrie() == 120);
+    REQUIRE(*MakeUnique<std::string>(3, 'a') == "aaa");
+    REQUIRE(MakeUnique<int[]>(3)[2] == 0);
+}
@@ -0,0 +1,124 @@
+#include "tagged_unique.h"
+
+#include "deleters.h"
+
+#include <common/my_int.h>
+
+#include <catch.hpp>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct alignas(8) TrieNode {
+    explicit TrieNode(int value = 0) : value(value) {
+    }
+
+    int value;
+    TaggedUniquePtr<TrieNode> children[2];
+};
+
+TEST_CASE("Tagged basic") {
+    SECTION("Sizeof") {
+        static_assert(sizeof(TaggedUniquePtr<int>) == sizeof(void*));
+        static_assert(sizeof(TaggedUniquePtr<TrieNode>) == sizeof(void*));
+        static_assert(sizeof(TrieNode) == 3 * sizeof(void*));
+    }
+
+    SECTION("Tag bits") {
+        static_assert(TaggedUniquePtr<char>::TagBits() == 0);
+        static_assert(TaggedUniquePtr<int>::TagBits() == 2);
+        static_assert(TaggedUniquePtr<TrieNode>::TagBits() == 3);
+    }
+
+    SECTION("Lifetime") {
+        {
+            TaggedUniquePtr<MyInt> s(new MyInt(5), 3);
+
+            REQUIRE(MyInt::AliveCount() == 1);
+            REQUIRE(*s == 5);
+            REQUIRE(s.GetTag() == 3);
+        }
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Get clears the tag") {
+        int* p = new int(1);
+        TaggedUniquePtr<int> s(p, 2);
+
+        REQUIRE(s.Get() == p);
+        s.SetTag(1);
+        REQUIRE(s.Get() == p);
+        REQUIRE(s.GetTag() == 1);
+    }
+
+    SECTION("Tag only") {
+        TaggedUniquePtr<int> s(nullptr, 3);
+
+        REQUIRE(!s);
+        REQUIRE(s.GetTag() == 3);
+    }
+}
+
+TEST_CASE("Tagged modifiers") {
+    SECTION("Move takes the tag") {
+        TaggedUniquePtr<MyInt> s1(new MyInt(1), 1);
+        TaggedUniquePtr<MyInt> s2(new MyInt(2), 2);
+        MyInt* p = s1.Get();
+        s2 = std::move(s1);
+
+        REQUIRE(MyInt::AliveCount() == 1);
+        REQUIRE(s2.Get() == p);
+        REQUIRE(s2.GetTag() == 1);
+        REQUIRE(s1.Get() == nullptr);
+        REQUIRE(s1.GetTag() == 0);
+
+        TaggedUniquePtr<MyInt> s3(std::move(s2));
+        REQUIRE(s3.Get() == p);
+        REQUIRE(s3.GetTag() == 1);
+    }
+
+    SECTION("Reset and Release keep the tag") {
+        TaggedUniquePtr<MyInt> s(new MyInt(1), 2);
+        s.Reset(new MyInt(3));
+
+        REQUIRE(MyInt::AliveCount() == 1);
+        REQUIRE(s.GetTag() == 2);
+        REQUIRE(*s == 3);
+
+        delete s.Release();
+        REQUIRE(s.GetTag() == 2);
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Custom deleter") {
+        TaggedUniquePtr<MyInt, Deleter<MyInt>> s(new MyInt, 1, Deleter<MyInt>(7));
+
+        REQUIRE(s.GetDeleter().GetTag() == 7);
+        s.Reset();
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Tree of tagged children") {
+        TrieNode root;
+        root.children[0] = TaggedUniquePtr<TrieNode>(new TrieNode(1), 5);
+        root.children[1] = TaggedUniquePtr<TrieNode>(new TrieNode(2), 7);
+        root.children[0]->children[1] = TaggedUniquePtr<TrieNode>(new TrieNode(3), 1);
+
+        REQUIRE(root.children[0]->value == 1);
+        REQUIRE(root.children[1].GetTag() == 7);
+        REQUIRE(root.children[0]->children[1]->value == 3);
+    }
+}
+
+TEST_CASE("Tagged comparisons") {
+    int* p = new int(1);
+    TaggedUniquePtr<int> a(p, 1);
+    TaggedUniquePtr<int> b(nullptr, 1);
+    TaggedUniquePtr<int> c(nullptr, 2);
+
+    REQUIRE(a == a);
+    REQUIRE(!(a == b));
+    REQUIRE(!(b == c));
+    REQUIRE(b == nullptr);
+    REQUIRE(c == nullptr);
+    REQUIRE(!(a == nullptr));
+}
@@ -2,19 +2,22 @@
 
 #include "compressed_pair.h"
 
+#include <common/trivially_relocatable.h>
+
 #include <cstddef>  // std::nullptr_t
 #include <type_traits>
+#include <utility>
 
 template <typename T>
 struct Slug {
     Slug() = default;
     template <class U>
-    Slug(T&& other){};
+    constexpr Slug(T&& other){};
     template <class U>
-    Slug(Slug<U> other){};
+    constexpr Slug(Slug<U> other){};
     ~Slug() = default;
     template <typename U>
-    void operator()(U&& other) {
+    constexpr void operator()(U&& other) {
         delete other;
     }
 };
@@ -23,12 +26,12 @@ template <typename T>
 struct Slug<T[]> {
     Slug() = default;
     template <class U>
-    Slug(T&& other){};
+    constexpr Slug(T&& other){};
     template <class U>
-    Slug(Slug<U> other){};
+    constexpr Slug(Slug<U> other){};
     ~Slug() = default;
     template <typename U>
-    void operator()(U&& other) {
+    constexpr void operator()(U&& other) {
         delete[] other;
     }
 };
@@ -40,29 +43,31 @@ public:
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Constructors
 
-    explicit UniquePtr(T* ptr = nullptr) noexcept {
+    constexpr explicit UniquePtr(T* ptr = nullptr) noexcept {
         pair_.GetFirst() = ptr;
     };
-    UniquePtr(T* ptr, Deleter deleter) noexcept {
+    constexpr UniquePtr(T* ptr, Deleter deleter) noexcept {
         pair_.GetFirst() = ptr;
         pair_.GetSecond() = std::forward<Deleter>(deleter);
     };
 
-    UniquePtr(UniquePtr&& other) noexcept {
+    constexpr UniquePtr(UniquePtr&& other) noexcept {
         this->Swap(other);
         other.Reset();
     };
 
+    // The deleter is converted along with the pointer, so it is only possible when it converts
     template <class U, class B>
-    UniquePtr(UniquePtr<U, B>&& other) noexcept {
+        requires std::is_convertible_v<B, Deleter>
+    constexpr UniquePtr(UniquePtr<U, B>&& other) noexcept {
+        pair_.GetSecond() = std::move(other.GetDeleter());
         pair_.GetFirst() = other.Release();
-        other.Reset();
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // `operator=`-s
 
-    UniquePtr& operator=(UniquePtr&& other) noexcept {
+    constexpr UniquePtr& operator=(UniquePtr&& other) noexcept {
         if (this == &other) {
             return *this;
         }
@@ -71,13 +76,14 @@ public:
         return *this;
     };
     template <class U, class B>
-    UniquePtr& operator=(UniquePtr<U, B>&& other) noexcept {
+        requires std::is_convertible_v<B, Deleter>
+    constexpr UniquePtr& operator=(UniquePtr<U, B>&& other) noexcept {
         pair_.GetSecond()(pair_.GetFirst());
+        pair_.GetSecond() = std::move(other.GetDeleter());
         pair_.GetFirst() = other.Release();
-        other.Reset();
         return *this;
     };
-    UniquePtr& operator=(std::nullptr_t) noexcept {
+    constexpr UniquePtr& operator=(std::nullptr_t) noexcept {
         pair_.GetSecond()(pair_.GetFirst());
         pair_.GetFirst() = nullptr;
         return *this;
@@ -86,40 +92,40 @@ public:
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Destructor
 
-    ~UniquePtr() {
+    constexpr ~UniquePtr() {
         pair_.GetSecond()(pair_.GetFirst());
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Modifiers
 
-    T* Release() noexcept {
+    constexpr T* Release() noexcept {
         T* ret = pair_.GetFirst();
         pair_.GetFirst() = nullptr;
         return ret;
     };
-    void Reset(T* ptr = nullptr) noexcept {
+    constexpr void Reset(T* ptr = nullptr) noexcept {
         T* el = pair_.GetFirst();
         pair_.GetFirst() = ptr;
         pair_.GetSecond()(el);
     };
-    void Swap(UniquePtr& other) noexcept {
+    constexpr void Swap(UniquePtr& other) noexcept {
         std::swap(pair_, other.pair_);
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Observers
 
-    T* Get() const noexcept {
+    constexpr T* Get() const noexcept {
         return pair_.GetFirst();
     };
-    Deleter& GetDeleter() noexcept {
+    constexpr Deleter& GetDeleter() noexcept {
         return pair_.GetSecond();
     };
-    const Deleter& GetDeleter() const noexcept {
+    constexpr const Deleter& GetDeleter() const noexcept {
         return pair_.GetSecond();
     };
-    explicit operator bool() const noexcept {
+    constexpr explicit operator bool() const noexcept {
         if (pair_.GetFirst() != nullptr) {
             return true;
         }
@@ -129,10 +135,10 @@ public:
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Single-object dereference operators
 
-    T& operator*() const noexcept {
+    constexpr T& operator*() const noexcept {
         return *pair_.GetFirst();
     };
-    T* operator->() const noexcept {
+    constexpr T* operator->() const noexcept {
         return pair_.GetFirst();
     };
 
@@ -146,29 +152,30 @@ public:
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Constructors
 
-    explicit UniquePtr(void* ptr = nullptr) noexcept {
+    constexpr explicit UniquePtr(void* ptr = nullptr) noexcept {
         pair_.GetFirst() = ptr;
     };
-    UniquePtr(void* ptr, Deleter deleter) noexcept {
+    constexpr UniquePtr(void* ptr, Deleter deleter) noexcept {
         pair_.GetFirst() = ptr;
         pair_.GetSecond() = std::forward<Deleter>(deleter);
     };
 
-    UniquePtr(UniquePtr&& other) noexcept {
+    constexpr UniquePtr(UniquePtr&& other) noexcept {
         this->Swap(other);
         other.Reset();
     };
 
     template <class U, class B>
-    UniquePtr(UniquePtr<U, B>&& other) noexcept {
+        requires std::is_convertible_v<B, Deleter>
+    constexpr UniquePtr(UniquePtr<U, B>&& other) noexcept {
+        pair_.GetSecond() = std::move(other.GetDeleter());
         pair_.GetFirst() = other.Release();
-        other.Reset();
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // `operator=`-s
 
-    UniquePtr& operator=(UniquePtr&& other) noexcept {
+    constexpr UniquePtr& operator=(UniquePtr&& other) noexcept {
         if (this == &other) {
             return *this;
         }
@@ -177,13 +184,14 @@ public:
         return *this;
     };
     template <class U, class B>
-    UniquePtr& operator=(UniquePtr<U, B>&& other) noexcept {
+        requires std::is_convertible_v<B, Deleter>
+    constexpr UniquePtr& operator=(UniquePtr<U, B>&& other) noexcept {
         pair_.GetSecond()(pair_.GetFirst());
+        pair_.GetSecond() = std::move(other.GetDeleter());
         pair_.GetFirst() = other.Release();
-        other.Reset();
         return *this;
     };
-    UniquePtr& operator=(std::nullptr_t) noexcept {
+    constexpr UniquePtr& operator=(std::nullptr_t) noexcept {
         if (pair_.GetFirst() != nullptr) {
             pair_.GetSecond()(pair_.GetFirst());
         }
@@ -194,40 +202,40 @@ public:
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Destructor
 
-    ~UniquePtr() {
+    constexpr ~UniquePtr() {
         pair_.GetSecond()(pair_.GetFirst());
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Modifiers
 
-    void* Release() noexcept {
+    constexpr void* Release() noexcept {
         void* ret = pair_.GetFirst();
         pair_.GetFirst() = nullptr;
         return ret;
     };
-    void Reset(void* ptr = nullptr) noexcept {
+    constexpr void Reset(void* ptr = nullptr) noexcept {
         void* el = pair_.GetFirst();
         pair_.GetFirst() = ptr;
         pair_.GetSecond()(el);
     };
-    void Swap(UniquePtr& other) noexcept {
+    constexpr void Swap(UniquePtr& other) noexcept {
         std::swap(pair_, other.pair_);
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Observers
 
-    void* Get() const noexcept {
+    constexpr void* Get() const noexcept {
         return pair_.GetFirst();
     };
-    Deleter& GetDeleter() noexcept {
+    constexpr Deleter& GetDeleter() noexcept {
         return pair_.GetSecond();
     };
-    const Deleter& GetDeleter() const noexcept {
+    constexpr const Deleter& GetDeleter() const noexcept {
         return pair_.GetSecond();
     };
-    explicit operator bool() const noexcept {
+    constexpr explicit operator bool() const noexcept {
         if (pair_.GetFirst() != nullptr) {
             return true;
         }
@@ -236,7 +244,7 @@ public:
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Single-object dereference operators
-    void* operator->() const noexcept {
+    constexpr void* operator->() const noexcept {
         return pair_.GetFirst();
     };
 
@@ -251,29 +259,30 @@ public:
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Constructors
 
-    explicit UniquePtr(T* ptr = nullptr) noexcept {
+    constexpr explicit UniquePtr(T* ptr = nullptr) noexcept {
         pair_.GetFirst() = ptr;
     };
-    UniquePtr(T* ptr, Deleter deleter) noexcept {
+    constexpr UniquePtr(T* ptr, Deleter deleter) noexcept {
         pair_.GetFirst() = ptr;
         pair_.GetSecond() = std::forward<Deleter>(deleter);
     };
 
-    UniquePtr(UniquePtr&& other) noexcept {
+    constexpr UniquePtr(UniquePtr&& other) noexcept {
         this->Swap(other);
         other.Reset();
     };
 
     template <class U, class B>
-    UniquePtr(UniquePtr<U, B>&& other) noexcept {
+        requires std::is_convertible_v<B, Deleter>
+    constexpr UniquePtr(UniquePtr<U, B>&& other) noexcept {
+        pair_.GetSecond() = std::move(other.GetDeleter());
         pair_.GetFirst() = other.Release();
-        other.Reset();
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // `operator=`-s
 
-    UniquePtr& operator=(UniquePtr&& other) noexcept {
+    constexpr UniquePtr& operator=(UniquePtr&& other) noexcept {
         if (this == &other) {
             return *this;
         }
@@ -282,13 +291,14 @@ public:
         return *this;
     };
     template <class U, class B>
-    UniquePtr& operator=(UniquePtr<U, B>&& other) noexcept {
+        requires std::is_convertible_v<B, Deleter>
+    constexpr UniquePtr& operator=(UniquePtr<U, B>&& other) noexcept {
         pair_.GetSecond()(pair_.GetFirst());
+        pair_.GetSecond() = std::move(other.GetDeleter());
         pair_.GetFirst() = other.Release();
-        other.Reset();
         return *this;
     };
-    UniquePtr& operator=(std::nullptr_t) noexcept {
+    constexpr UniquePtr& operator=(std::nullptr_t) noexcept {
         if (pair_.GetFirst() != nullptr) {
             pair_.GetSecond()(pair_.GetFirst());
         }
@@ -299,40 +309,40 @@ public:
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Destructor
 
-    ~UniquePtr() {
+    constexpr ~UniquePtr() {
         pair_.GetSecond()(pair_.GetFirst());
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Modifiers
 
-    T* Release() noexcept {
+    constexpr T* Release() noexcept {
         T* ret = pair_.GetFirst();
         pair_.GetFirst() = nullptr;
         return ret;
     };
-    void Reset(T* ptr = nullptr) noexcept {
+    constexpr void Reset(T* ptr = nullptr) noexcept {
         T* el = pair_.GetFirst();
         pair_.GetFirst() = ptr;
         pair_.GetSecond()(el);
     };
-    void Swap(UniquePtr& other) noexcept {
+    constexpr void Swap(UniquePtr& other) noexcept {
         std::swap(pair_, other.pair_);
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Observers
 
-    T* Get() const noexcept {
+    constexpr T* Get() const noexcept {
         return pair_.GetFirst();
     };
-    Deleter& GetDeleter() noexcept {
+    constexpr Deleter& GetDeleter() noexcept {
         return pair_.GetSecond();
     };
-    const Deleter& GetDeleter() const noexcept {
+    constexpr const Deleter& GetDeleter() const noexcept {
         return pair_.GetSecond();
     };
-    explicit operator bool() const noexcept {
+    constexpr explicit operator bool() const noexcept {
         if (pair_.GetFirst() != nullptr) {
             return true;
         }
@@ -342,16 +352,35 @@ public:
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Single-object dereference operators
 
-    T& operator*() const noexcept {
+    constexpr T& operator*() const noexcept {
         return *pair_.GetFirst();
     };
-    T* operator->() const noexcept {
+    constexpr T* operator->() const noexcept {
         return pair_.GetFirst();
     };
-    T& operator[](size_t ind) const noexcept {
+    constexpr T& operator[](size_t ind) const noexcept {
         return pair_.GetFirst()[ind];
     }
 
 private:
     CompressedPair<T*, Deleter> pair_;
 };
+
+// Usable in constant evaluation: a `constexpr` function may build a structure out of
+// `MakeUnique` nodes, check it, and free it before returning
+template <typename T, typename... Args>
+    requires(!std::is_array_v<T>)
+constexpr UniquePtr<T> MakeUnique(Args&&... args) {
+    return UniquePtr<T>(new T(std::forward<Args>(args)...));
+};
+
+// Value-initialized array of `size` elements
+template <typename T>
+    requires std::is_unbounded_array_v<T>
+constexpr UniquePtr<T> MakeUnique(size_t size) {
+    return UniquePtr<T>(new std::remove_extent_t<T>[size]());
+};
+
+// Moving a `UniquePtr` is a byte copy as long as moving its deleter is
+template <typename T, typename Deleter>
+struct IsTriviallyRelocatable<UniquePtr<T, Deleter>> : IsTriviallyRelocatable<Deleter> {};
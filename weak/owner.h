@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>  // size_t
+
+// Functors that order, hash and compare `SharedPtr` and `WeakPtr` by owner (control block),
+// not by the stored pointer. Mixed `SharedPtr`/`WeakPtr` arguments are allowed.
+// https://en.cppreference.com/w/cpp/memory/owner_less
+
+struct OwnerLess {
+    using is_transparent = void;
+
+    template <typename A, typename B>
+    bool operator()(const A& left, const B& right) const {
+        return left.OwnerBefore(right);
+    }
+};
+
+struct OwnerHash {
+    using is_transparent = void;
+
+    template <typename P>
+    size_t operator()(const P& ptr) const {
+        return ptr.OwnerHash();
+    }
+};
+
+struct OwnerEqual {
+    using is_transparent = void;
+
+    template <typename A, typename B>
+    bool operator()(const A& left, const B& right) const {
+        return left.OwnerEquals(right);
+    }
+};
@@ -2,9 +2,106 @@
 
 #include "sw_fwd.h"  // Forward declaration
 
+#include <common/fast_dynamic_cast.h>
+#include <common/trivially_relocatable.h>
+#include <unique/unique.h>
+
 #include <cstddef>  // std::nullptr_t
+#include <cstdint>  // uintptr_t
+#include <functional>  // std::less, std::hash
 #include <type_traits>
 
+// How a sole owner deletes its object and gives it a control block. Both are captured where
+// the pointer is adopted, so they stay right where `T` is incomplete (e.g. a pimpl copied in
+// a translation unit that only sees its declaration).
+struct SoleOwnerOps {
+    void (*destroy)(void* object) noexcept;
+    ControlBlock* (*share)(void* object);
+};
+
+template <typename T>
+inline constexpr SoleOwnerOps kSoleOwnerOps{
+    [](void* object) noexcept { delete static_cast<T*>(object); },
+    [](void* object) -> ControlBlock* {
+        return new ControlBlockWithPtr<T>(static_cast<T*>(object));
+    },
+};
+
+template <typename T, typename Deleter>
+class ControlBlockWithDeleter : public ControlBlock {
+public:
+    size_t UseStrongCount() override {
+        return strong_counter_;
+    }
+    size_t UseWeakCount() override {
+        return weak_counter_;
+    }
+    void IncrementStrong() override {
+        ++strong_counter_;
+    }
+    void AddStrong(size_t count) override {
+        strong_counter_ += count;
+    }
+    bool TryIncrementStrong() override {
+        if (strong_counter_ == 0) {
+            return false;
+        }
+        ++strong_counter_;
+        return true;
+    }
+    void DecrementStrong() override {
+        --strong_counter_;
+        if (strong_counter_ == 0) {
+            // The object may hold the last `WeakPtr` to itself, keep the block until it is gone
+            ++weak_counter_;
+            pair_.GetSecond()(pair_.GetFirst());
+            --weak_counter_;
+        }
+    }
+    void IncrementWeak() override {
+        ++weak_counter_;
+    }
+    void DecrementWeak() override {
+        --weak_counter_;
+    }
+    ControlBlockWithDeleter(T* ptr, Deleter&& deleter) : pair_(ptr, std::move(deleter)) {
+        strong_counter_ = 1;
+        weak_counter_ = 0;
+    }
+    ~ControlBlockWithDeleter(){};
+
+private:
+    size_t strong_counter_{};
+    size_t weak_counter_{};
+    CompressedPair<T*, Deleter> pair_;
+};
+
+// Deleter of `UniquePtr`-s made by `MakeUniqueShareable`.
+// The object already lives inside a control block, so promotion to `SharedPtr` is free.
+template <typename T>
+class ShareableDelete {
+public:
+    template <typename Y>
+    friend class SharedPtr;
+
+    ShareableDelete() = default;
+    explicit ShareableDelete(ControlBlockWithObject<T>* block) : block_(block) {
+    }
+    // Only a `SharedPtr<T>` can take over the block, no other deleter may stand in for it
+    template <typename D>
+    operator D() const = delete;
+
+    void operator()(T* ptr) {
+        if (ptr != nullptr) {
+            block_->DecrementStrong();
+            delete block_;
+        }
+    }
+
+private:
+    ControlBlockWithObject<T>* block_ = nullptr;
+};
+
 // https://en.cppreference.com/w/cpp/memory/shared_ptr
 template <typename T>
 class SharedPtr {
@@ -13,6 +110,14 @@ public:
     friend class SharedPtr;
     template <typename Y>
     friend class WeakPtr;
+    template <typename U, typename Y>
+    friend SharedPtr<U> StaticPointerCast(SharedPtr<Y>&& other);
+    template <typename U, typename Y>
+    friend SharedPtr<U> DynamicPointerCast(SharedPtr<Y>&& other);
+    template <typename U, typename Y>
+    friend SharedPtr<U> ConstPointerCast(SharedPtr<Y>&& other);
+    template <typename U, typename Y>
+    friend SharedPtr<U> FastDynamicPointerCast(SharedPtr<Y>&& other);
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Constructors
 
@@ -26,27 +131,58 @@ public:
     };
     explicit SharedPtr(T* ptr) {
         object_ptr_ = ptr;
-        if (ptr != nullptr) {
-            block_ = new ControlBlockWithPtr<T>(ptr);
-        }
+        block_ = NewBlock(ptr);
     };
     template <typename Y>
     explicit SharedPtr(Y* ptr) {
         object_ptr_ = ptr;
-        if (ptr != nullptr) {
-            block_ = new ControlBlockWithPtr<Y>(ptr);
-        }
+        block_ = NewBlock(ptr);
     };
+    // Adopts `ptr` without a control block: the sole owner keeps only the pointer and deletes
+    // it itself, for pointers that are often never shared. The block is allocated by the first
+    // copy, aliasing or `WeakPtr` (see `Materialize`), which updates the source even through
+    // a const reference; copies stay `noexcept`, so that allocation failing terminates.
+    // A `Y` that cannot be deleted through `T*` gets its block right away.
+    template <typename Y>
+    static SharedPtr AdoptLazy(Y* ptr) {
+        SharedPtr result;
+        result.object_ptr_ = ptr;
+        result.block_ = Adopted(ptr);
+        return result;
+    }
     template <typename Y>
     SharedPtr(ControlBlockWithObject<Y>* block, T* ptr) {
         object_ptr_ = ptr;
         block_ = block;
     }
+    // Take over a `UniquePtr` together with its deleter
+    // #13 from https://en.cppreference.com/w/cpp/memory/shared_ptr/shared_ptr
+    template <typename Y, typename Deleter>
+    SharedPtr(UniquePtr<Y, Deleter>&& other) {
+        object_ptr_ = other.Get();
+        block_ = nullptr;
+        if (other) {
+            block_ = new ControlBlockWithDeleter<Y, Deleter>(other.Get(),
+                                                             std::move(other.GetDeleter()));
+            other.Release();
+        }
+    }
+    // The control block was reserved by `MakeUniqueShareable`, no allocation here
+    template <typename Y>
+    SharedPtr(UniquePtr<Y, ShareableDelete<Y>>&& other) noexcept {
+        object_ptr_ = other.Get();
+        block_ = nullptr;
+        if (other) {
+            block_ = other.GetDeleter().block_;
+            other.Release();
+        }
+    }
 
+    // Only the first copy of a sole owner made by `AdoptLazy` allocates
     SharedPtr(const SharedPtr& other) noexcept {
         if (other) {
             object_ptr_ = other.object_ptr_;
-            block_ = other.block_;
+            block_ = other.Materialize();
             block_->IncrementStrong();
         } else {
             object_ptr_ = nullptr;
@@ -57,7 +193,7 @@ public:
     SharedPtr(const SharedPtr<Y>& other) noexcept {
         if (other) {
             object_ptr_ = other.object_ptr_;
-            block_ = other.block_;
+            block_ = other.Materialize();
             block_->IncrementStrong();
         } else {
             object_ptr_ = nullptr;
@@ -72,8 +208,8 @@ public:
     };
     template <typename Y>
     SharedPtr(SharedPtr<Y>&& other) {
+        block_ = BlockOf(other, other.object_ptr_);
         object_ptr_ = other.object_ptr_;
-        block_ = other.block_;
         other.object_ptr_ = nullptr;
         other.block_ = nullptr;
     }
@@ -84,24 +220,35 @@ public:
     SharedPtr(const SharedPtr<Y>& other, T* ptr) {
         if (other) {
             object_ptr_ = ptr;
-            block_ = other.block_;
+            block_ = other.Materialize();
             block_->IncrementStrong();
         } else {
             block_ = nullptr;
             object_ptr_ = nullptr;
         }
     };
+    // Takes over the reference of `other` without touching the counter
+    template <typename Y>
+    SharedPtr(SharedPtr<Y>&& other, T* ptr) {
+        if (other) {
+            object_ptr_ = ptr;
+            block_ = other.Materialize();
+            other.object_ptr_ = nullptr;
+            other.block_ = nullptr;
+        } else {
+            block_ = nullptr;
+            object_ptr_ = nullptr;
+        }
+    };
 
     // Promote `WeakPtr`
     // #11 from https://en.cppreference.com/w/cpp/memory/shared_ptr/shared_ptr
     explicit SharedPtr(const WeakPtr<T>& other) {
-        if (other.Expired()) {
+        if (other.block_ == nullptr || !other.block_->TryIncrementStrong()) {
             throw BadWeakPtr();
-        } else {
-            object_ptr_ = other.object_ptr_;
-            block_ = other.block_;
-            block_->IncrementStrong();
         }
+        object_ptr_ = other.object_ptr_;
+        block_ = other.block_;
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -111,16 +258,12 @@ public:
         if (this == &other) {
             return *this;
         }
-        if (block_ == other.block_) {
+        other.Materialize();
+        if (block_ == other.block_ && block_ != nullptr) {
             object_ptr_ = other.object_ptr_;
             return *this;
         }
-        if (*this) {
-            block_->DecrementStrong();
-            if (block_->UseStrongCount() == 0 && block_->UseWeakCount() == 0) {
-                delete block_;
-            }
-        }
+        DropOwnership();
         object_ptr_ = other.object_ptr_;
         block_ = other.block_;
         if (other) {
@@ -137,10 +280,11 @@ public:
         return *this;
     };
     template <typename Y>
-    SharedPtr& operator=(SharedPtr<Y>&& other) noexcept {
+    SharedPtr& operator=(SharedPtr<Y>&& other) {
+        ControlBlock* block = BlockOf(other, other.object_ptr_);
         this->Reset();
         object_ptr_ = other.object_ptr_;
-        block_ = other.block_;
+        block_ = block;
         other.object_ptr_ = nullptr;
         other.block_ = nullptr;
         return *this;
@@ -149,52 +293,61 @@ public:
     // Destructor
 
     ~SharedPtr() {
-        if (*this) {
-            block_->DecrementStrong();
-            if (block_->UseStrongCount() == 0 && block_->UseWeakCount() == 0) {
-                delete block_;
-            }
-        }
+        DropOwnership();
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Modifiers
 
     void Reset() noexcept {
-        if (*this) {
-            block_->DecrementStrong();
-            if (block_->UseStrongCount() == 0 && block_->UseWeakCount() == 0) {
-                delete block_;
-            }
-            block_ = nullptr;
-            object_ptr_ = nullptr;
-        }
+        DropOwnership();
+        block_ = nullptr;
+        object_ptr_ = nullptr;
     };
     void Reset(T* ptr) {
-        if (*this) {
-            block_->DecrementStrong();
-            if (block_->UseStrongCount() == 0 && block_->UseWeakCount() == 0) {
-                delete block_;
-            }
-        }
+        ControlBlock* block = NewBlock(ptr);
+        DropOwnership();
         object_ptr_ = ptr;
-        block_ = new ControlBlockWithPtr(ptr);
+        block_ = block;
     };
     template <typename Y>
     void Reset(Y* ptr) {
-        if (*this) {
-            block_->DecrementStrong();
-            if (block_->UseStrongCount() == 0 && block_->UseWeakCount() == 0) {
-                delete block_;
-            }
-        }
+        ControlBlock* block = NewBlock(ptr);
+        DropOwnership();
         object_ptr_ = ptr;
-        block_ = new ControlBlockWithPtr(ptr);
+        block_ = block;
     };
     void Swap(SharedPtr& other) noexcept {
         std::swap(object_ptr_, other.object_ptr_);
         std::swap(block_, other.block_);
     };
+    // Writes `count` copies of `*this` to `out` with a single counter update
+    template <typename OutputIt>
+    OutputIt ShareN(size_t count, OutputIt out) const {
+        if (count == 0) {
+            return out;
+        }
+        if (*this) {
+            Materialize()->AddStrong(count);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            // Adopts one of the references added above
+            SharedPtr copy;
+            copy.object_ptr_ = object_ptr_;
+            copy.block_ = object_ptr_ != nullptr ? block_ : nullptr;
+            try {
+                *out = std::move(copy);
+            } catch (...) {
+                // `copy` gives back its own reference, return the ones not handed out yet
+                for (size_t j = i + 1; *this && j < count; ++j) {
+                    block_->DecrementStrong();
+                }
+                throw;
+            }
+            ++out;
+        }
+        return out;
+    };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Observers
@@ -209,22 +362,199 @@ public:
         return object_ptr_;
     };
     size_t UseCount() const noexcept {
-        if (*this) {
-            return block_->UseStrongCount();
+        if (IsSoleOwner()) {
+            return 1;
         }
-        return 0;
+        return block_ != nullptr ? block_->UseStrongCount() : 0;
     };
     explicit operator bool() const noexcept {
         return object_ptr_ != nullptr;
     };
 
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Owner-based ordering and hashing
+    // Pointers are compared by their control block, so a `WeakPtr` keeps its place after the
+    // object expires. A sole owner gets its control block here.
+
+    template <typename Y>
+    bool OwnerBefore(const SharedPtr<Y>& other) const {
+        return std::less<const ControlBlock*>()(Materialize(), other.Materialize());
+    };
+    template <typename Y>
+    bool OwnerBefore(const WeakPtr<Y>& other) const {
+        return std::less<const ControlBlock*>()(Materialize(), other.block_);
+    };
+    template <typename Y>
+    bool OwnerEquals(const SharedPtr<Y>& other) const {
+        return Materialize() == other.Materialize();
+    };
+    template <typename Y>
+    bool OwnerEquals(const WeakPtr<Y>& other) const {
+        return Materialize() == other.block_;
+    };
+    size_t OwnerHash() const {
+        return std::hash<const ControlBlock*>()(Materialize());
+    };
+
 private:
+    // Deleting a `Y` through `T*` is only correct for the same type or a virtual destructor,
+    // otherwise the control block has to remember `Y` from the start
+    template <typename Y>
+    static constexpr bool kCanDeleteAs = std::is_same_v<std::remove_cv_t<Y>, std::remove_cv_t<T>> ||
+                                         std::has_virtual_destructor_v<T>;
+
+    void DropOwnership() noexcept {
+        if (IsSoleOwner()) {
+            GetSoleOwnerOps().destroy(Address());
+        } else if (*this) {
+            block_->DecrementStrong();
+            if (block_->UseStrongCount() == 0 && block_->UseWeakCount() == 0) {
+                delete block_;
+            }
+        }
+    }
+
+    // Allocates the control block of a sole owner, called before ownership is shared
+    ControlBlock* Materialize() const {
+        if (IsSoleOwner()) {
+            block_ = GetSoleOwnerOps().share(Address());
+        }
+        return block_;
+    }
+
+    // A sole owner keeps the `SoleOwnerOps` of `T` in place of the control block,
+    // tagged with the low bit
+    static ControlBlock* SoleOwner(T* ptr) noexcept {
+        if (ptr == nullptr) {
+            return nullptr;
+        }
+        auto address = reinterpret_cast<uintptr_t>(&kSoleOwnerOps<std::remove_cv_t<T>>);
+        return reinterpret_cast<ControlBlock*>(address | 1);
+    }
+    bool IsSoleOwner() const noexcept {
+        return (reinterpret_cast<uintptr_t>(block_) & 1) != 0;
+    }
+    const SoleOwnerOps& GetSoleOwnerOps() const noexcept {
+        return *reinterpret_cast<const SoleOwnerOps*>(reinterpret_cast<uintptr_t>(block_) - 1);
+    }
+    void* Address() const noexcept {
+        return const_cast<std::remove_cv_t<T>*>(object_ptr_);
+    }
+
+    // Takes over the reference of `other`, `ptr` is the same object seen as a `T`.
+    // Unlike the aliasing constructor, a sole owner stays without a control block
+    // when the object can be deleted through `T*`.
+    template <typename Y>
+    static SharedPtr Adopt(SharedPtr<Y>&& other, T* ptr) {
+        SharedPtr result;
+        result.block_ = BlockOf(other, ptr);
+        result.object_ptr_ = ptr;
+        other.object_ptr_ = nullptr;
+        other.block_ = nullptr;
+        return result;
+    }
+
+    template <typename Y>
+    static ControlBlock* NewBlock(Y* ptr) {
+        return ptr != nullptr ? new ControlBlockWithPtr<Y>(ptr) : nullptr;
+    }
+    // Ownership of a `Y` adopted by `AdoptLazy`
+    template <typename Y>
+    static ControlBlock* Adopted(Y* ptr) {
+        if constexpr (kCanDeleteAs<Y>) {
+            return SoleOwner(ptr);
+        } else {
+            return NewBlock(ptr);
+        }
+    }
+    // The control block of `other` once it owns the object as `ptr`. The operations of
+    // a sole owner are those of `T` after that, the same ones if only cv-qualifiers differ.
+    template <typename Y>
+    static ControlBlock* BlockOf(const SharedPtr<Y>& other, T* ptr) {
+        if constexpr (!kCanDeleteAs<Y>) {
+            return other.Materialize();
+        } else if constexpr (!std::is_same_v<std::remove_cv_t<Y>, std::remove_cv_t<T>>) {
+            if (other.IsSoleOwner()) {
+                return SoleOwner(ptr);
+            }
+        }
+        return other.block_;
+    }
+
     T* object_ptr_;
-    ControlBlock* block_;
+    mutable ControlBlock* block_;
+};
+
+template <typename T>
+struct IsTriviallyRelocatable<SharedPtr<T>> : std::true_type {};
+
+template <typename T, typename U>
+inline bool operator==(const SharedPtr<T>& left, const SharedPtr<U>& right) {
+    return left.Get() == right.Get();
 };
 
+// Orders by the stored pointer, see `OwnerBefore` for ordering by owner
 template <typename T, typename U>
-inline bool operator==(const SharedPtr<T>& left, const SharedPtr<U>& right);
+inline bool operator<(const SharedPtr<T>& left, const SharedPtr<U>& right) {
+    return std::less<const void*>()(left.Get(), right.Get());
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Casts
+// https://en.cppreference.com/w/cpp/memory/shared_ptr/pointer_cast
+// The rvalue overloads move the reference from the source, the counter is not touched.
+// A failed dynamic cast returns an empty pointer and leaves the source as it was.
+
+template <typename T, typename Y>
+SharedPtr<T> StaticPointerCast(const SharedPtr<Y>& other) {
+    return SharedPtr<T>(other, static_cast<T*>(other.Get()));
+};
+template <typename T, typename Y>
+SharedPtr<T> StaticPointerCast(SharedPtr<Y>&& other) {
+    T* ptr = static_cast<T*>(other.Get());
+    return SharedPtr<T>::Adopt(std::move(other), ptr);
+};
+
+template <typename T, typename Y>
+SharedPtr<T> DynamicPointerCast(const SharedPtr<Y>& other) {
+    if (T* ptr = dynamic_cast<T*>(other.Get())) {
+        return SharedPtr<T>(other, ptr);
+    }
+    return SharedPtr<T>();
+};
+template <typename T, typename Y>
+SharedPtr<T> DynamicPointerCast(SharedPtr<Y>&& other) {
+    if (T* ptr = dynamic_cast<T*>(other.Get())) {
+        return SharedPtr<T>::Adopt(std::move(other), ptr);
+    }
+    return SharedPtr<T>();
+};
+
+template <typename T, typename Y>
+SharedPtr<T> ConstPointerCast(const SharedPtr<Y>& other) {
+    return SharedPtr<T>(other, const_cast<T*>(other.Get()));
+};
+template <typename T, typename Y>
+SharedPtr<T> ConstPointerCast(SharedPtr<Y>&& other) {
+    T* ptr = const_cast<T*>(other.Get());
+    return SharedPtr<T>::Adopt(std::move(other), ptr);
+};
+
+// `DynamicPointerCast` for closed hierarchies, see common/fast_dynamic_cast.h
+template <typename T, typename Y>
+SharedPtr<T> FastDynamicPointerCast(const SharedPtr<Y>& other) {
+    if (T* ptr = FastDynamicCast<T>(other.Get())) {
+        return SharedPtr<T>(other, ptr);
+    }
+    return SharedPtr<T>();
+};
+template <typename T, typename Y>
+SharedPtr<T> FastDynamicPointerCast(SharedPtr<Y>&& other) {
+    if (T* ptr = FastDynamicCast<T>(other.Get())) {
+        return SharedPtr<T>::Adopt(std::move(other), ptr);
+    }
+    return SharedPtr<T>();
+};
 
 // Allocate memory only once
 template <typename T, typename... Args>
@@ -233,6 +563,25 @@ SharedPtr<T> MakeShared(Args&&... args) {
     return SharedPtr(block, block->Get());
 };
 
+// For objects shared everywhere that never die: sentinels, empty defaults, interned constants.
+// The strong count starts above `ControlBlock::kImmortalRefCount`, like `RefCounted::MakeImmortal`:
+// copies and releases only read it, and the object and its block are never freed.
+// `UseCount` of the result is always 2. Keep it in a static to keep it reachable.
+template <typename T, typename... Args>
+SharedPtr<T> MakeImmortalShared(Args&&... args) {
+    ControlBlockWithObject<T>* block = new ControlBlockWithObject<T>(std::forward<Args>(args)...);
+    block->AddStrong(ControlBlock::kImmortalRefCount);
+    return SharedPtr(block, block->Get());
+};
+
+// Same single allocation as `MakeShared`, but starts as a sole owner.
+// Moving the result into a `SharedPtr` reuses the reserved control block.
+template <typename T, typename... Args>
+UniquePtr<T, ShareableDelete<T>> MakeUniqueShareable(Args&&... args) {
+    ControlBlockWithObject<T>* block = new ControlBlockWithObject<T>(std::forward<Args>(args)...);
+    return UniquePtr<T, ShareableDelete<T>>(block->Get(), ShareableDelete<T>(block));
+};
+
 // Look for usage examples in tests
 template <typename T>
 class EnableSharedFromThis {
@@ -9,30 +9,65 @@ public:
     virtual void IncrementWeak() = 0;
     virtual void DecrementWeak() = 0;
     virtual void IncrementStrong() = 0;
+    // Adds `count` strong references at once
+    virtual void AddStrong(size_t count) = 0;
+    // Adds a strong reference unless the object is already gone, in one step
+    virtual bool TryIncrementStrong() = 0;
     virtual void DecrementStrong() = 0;
     virtual size_t UseStrongCount() = 0;
     virtual size_t UseWeakCount() = 0;
     virtual ~ControlBlock() = default;
+
+    // `MakeImmortalShared` biases the strong count past anything a program reaches. The blocks
+    // it makes stop counting above the bias, like `RefCounted::IsImmortal`, and report
+    // `kImmortalUseCount`: an immortal object is always shared, never unique.
+    static constexpr size_t kImmortalRefCount = size_t{1} << (sizeof(size_t) * 8 - 2);
+    static constexpr size_t kImmortalUseCount = 2;
 };
 
 template <typename T>
 class ControlBlockWithObject : public ControlBlock {
 public:
     size_t UseStrongCount() override {
-        return strong_counter_;
+        return strong_counter_ < kImmortalRefCount ? strong_counter_ : kImmortalUseCount;
     }
     size_t UseWeakCount() override {
         return weak_counter_;
     }
     void IncrementStrong() override {
+        if (strong_counter_ >= kImmortalRefCount) [[unlikely]] {
+            return;
+        }
+        ++strong_counter_;
+    }
+    void AddStrong(size_t count) override {
+        if (strong_counter_ >= kImmortalRefCount) [[unlikely]] {
+            return;
+        }
+        strong_counter_ += count;
+    }
+    bool TryIncrementStrong() override {
+        if (strong_counter_ == 0) {
+            return false;
+        }
+        if (strong_counter_ >= kImmortalRefCount) [[unlikely]] {
+            return true;
+        }
         ++strong_counter_;
+        return true;
     }
     void DecrementStrong() override {
+        if (strong_counter_ >= kImmortalRefCount) [[unlikely]] {
+            return;
+        }
         --strong_counter_;
         if (strong_counter_ == 0) {
+            // The object may hold the last `WeakPtr` to itself, keep the block until it is gone
+            ++weak_counter_;
             if (Get() != nullptr) {
                 Get()->~T();
             }
+            --weak_counter_;
         }
     }
     void IncrementWeak() override {
@@ -70,10 +105,23 @@ public:
     void IncrementStrong() override {
         ++strong_counter_;
     }
+    void AddStrong(size_t count) override {
+        strong_counter_ += count;
+    }
+    bool TryIncrementStrong() override {
+        if (strong_counter_ == 0) {
+            return false;
+        }
+        ++strong_counter_;
+        return true;
+    }
     void DecrementStrong() override {
         --strong_counter_;
         if (strong_counter_ == 0) {
+            // The object may hold the last `WeakPtr` to itself, keep the block until it is gone
+            ++weak_counter_;
             delete object_;
+            --weak_counter_;
         }
     }
     void IncrementWeak() override {
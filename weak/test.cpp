@@ -28,6 +28,11 @@ TEST_CASE("No unexpected allocations") {
 
     SharedPtr<int> sp2(new int(42));
     EXPECT_ZERO_ALLOCATIONS(WeakPtr<int>{sp2});
+
+    // The control block of a lazily adopted pointer is allocated by the first WeakPtr
+    auto sp3 = SharedPtr<int>::AdoptLazy(new int(42));
+    EXPECT_ONE_ALLOCATION(WeakPtr<int>{sp3});
+    EXPECT_ZERO_ALLOCATIONS(WeakPtr<int>{sp3});
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -147,6 +152,24 @@ TEST_CASE("Shared from invalid Weak") {
     REQUIRE_THROWS_AS(SharedPtr<int>(w_ptr), BadWeakPtr);
 }
 
+TEST_CASE("TryLock") {
+    WeakPtr<int> empty;
+    static_assert(noexcept(empty.TryLock()), "Operation must be noexcept");
+    REQUIRE(!empty.TryLock());
+
+    WeakPtr<int> w_ptr;
+    {
+        SharedPtr<int> ptr = MakeShared<int>(42);
+        w_ptr = ptr;
+
+        SharedPtr<int> locked = w_ptr.TryLock();
+        REQUIRE(*locked == 42);
+        REQUIRE(ptr.UseCount() == 2);
+    }
+    REQUIRE(!w_ptr.TryLock());
+    REQUIRE(!w_ptr.Lock());
+}
+
 TEST_CASE("Constness") {
     SharedPtr<int> sp(new int(42));
     WeakPtr<const int> wp(sp);
@@ -174,4 +197,108 @@ TEST_CASE("Lifetimes") {
         }
         delete wp;
     }
+
+    SECTION("Object holds the last weak pointer to itself") {
+        struct Node {
+            WeakPtr<Node> self;
+        };
+        auto made = MakeShared<Node>();
+        made->self = made;
+        made.Reset();
+
+        SharedPtr<Node> adopted(new Node);
+        adopted->self = adopted;
+        adopted.Reset();
+    }
+}
+
+// Defined in test_incomplete.cpp
+struct Opaque;
+SharedPtr<Opaque> MakeOpaque();
+int OpaqueDestroyed();
+
+TEST_CASE("Lazy control block") {
+    SECTION("Weak from a sole owner") {
+        auto sp = SharedPtr<MyInt>::AdoptLazy(new MyInt(1));
+        WeakPtr<MyInt> wp(sp);
+
+        REQUIRE(sp.UseCount() == 1);
+        REQUIRE(!wp.Expired());
+        REQUIRE(wp.Lock().Get() == sp.Get());
+
+        sp.Reset();
+        REQUIRE(wp.Expired());
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Weak from a sole owner after a move") {
+        auto sp = SharedPtr<MyInt>::AdoptLazy(new MyInt(1));
+        SharedPtr<const MyInt> moved = std::move(sp);
+        WeakPtr<const MyInt> wp(moved);
+
+        REQUIRE(!wp.Expired());
+        moved.Reset();
+        REQUIRE(wp.Expired());
+    }
+
+    SECTION("Incomplete type") {
+        int destroyed = OpaqueDestroyed();
+        WeakPtr<Opaque> wp;
+        {
+            SharedPtr<Opaque> sp = MakeOpaque();
+            wp = sp;
+            REQUIRE(!wp.Expired());
+        }
+        REQUIRE(wp.Expired());
+        REQUIRE(OpaqueDestroyed() == destroyed + 1);
+    }
+}
+
+TEST_CASE("WeakPtr to a promoted UniquePtr") {
+    SECTION("MakeUniqueShareable") {
+        auto up = MakeUniqueShareable<MyInt>(3);
+        SharedPtr<MyInt> sp(std::move(up));
+        WeakPtr<MyInt> wp(sp);
+
+        REQUIRE(wp.Lock().Get() == sp.Get());
+        sp.Reset();
+        REQUIRE(wp.Expired());
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("UniquePtr with a deleter") {
+        struct CountingDelete {
+            void operator()(MyInt* ptr) {
+                if (ptr != nullptr) {
+                    ++*calls;
+                    delete ptr;
+                }
+            }
+
+            int* calls = nullptr;
+        };
+        int calls = 0;
+        UniquePtr<MyInt, CountingDelete> up(new MyInt(3), CountingDelete{&calls});
+        SharedPtr<MyInt> sp(std::move(up));
+        WeakPtr<MyInt> wp(sp);
+
+        REQUIRE(wp.Lock().Get() == sp.Get());
+        sp.Reset();
+        REQUIRE(wp.Expired());
+        REQUIRE(calls == 1);
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+}
+
+TEST_CASE("WeakPtr to an immortal object") {
+    static const SharedPtr<int> kZero = MakeImmortalShared<int>(0);
+    WeakPtr<int> wp(kZero);
+    {
+        SharedPtr<int> locked = wp.Lock();
+        SharedPtr<int> promoted(wp);
+        REQUIRE(locked.Get() == kZero.Get());
+        REQUIRE(wp.UseCount() == 2);
+    }
+    REQUIRE(!wp.Expired());
+    REQUIRE(wp.TryLock());
 }
@@ -0,0 +1,121 @@
+#include "shared.h"
+#include "weak.h"
+#include "weak_value_cache.h"
+
+#include <catch.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("WeakValueCache") {
+    int builds = 0;
+    auto build = [&builds](int key) {
+        ++builds;
+        return MakeShared<std::string>(std::to_string(key));
+    };
+
+    SECTION("Returns the live value") {
+        WeakValueCache<int, std::string> cache;
+        auto first = cache.GetOrCreate(1, build);
+        auto second = cache.GetOrCreate(1, build);
+
+        REQUIRE(*first == "1");
+        REQUIRE(first.Get() == second.Get());
+        REQUIRE(builds == 1);
+        REQUIRE(cache.Find(1).Get() == first.Get());
+    }
+
+    SECTION("Does not keep values alive") {
+        WeakValueCache<int, std::string> cache;
+        auto value = cache.GetOrCreate(1, build);
+        REQUIRE(value.UseCount() == 1);
+
+        value.Reset();
+        REQUIRE(!cache.Find(1));
+        REQUIRE(cache.Size() == 0);
+
+        value = cache.GetOrCreate(1, build);
+        REQUIRE(builds == 2);
+        REQUIRE(*value == "1");
+    }
+
+    SECTION("Insert and erase") {
+        WeakValueCache<std::string, int> cache;
+        auto value = MakeShared<int>(5);
+        cache.Insert("five", value);
+
+        REQUIRE(cache.Find("five").Get() == value.Get());
+        REQUIRE(cache.Erase("five"));
+        REQUIRE_FALSE(cache.Erase("five"));
+        REQUIRE(!cache.Find("five"));
+    }
+
+    SECTION("Failed factory stores nothing") {
+        WeakValueCache<int, std::string> cache;
+        auto fail = [](int) -> SharedPtr<std::string> { throw std::runtime_error("failed"); };
+
+        REQUIRE_THROWS_AS(cache.GetOrCreate(1, fail), std::runtime_error);
+        REQUIRE(!cache.GetOrCreate(2, [](int) { return SharedPtr<std::string>(); }));
+        REQUIRE(cache.Size() == 0);
+    }
+
+    SECTION("Expired entries are swept incrementally") {
+        WeakValueCache<int, std::string> cache;
+        std::vector<SharedPtr<std::string>> values;
+        for (int i = 0; i < 100; ++i) {
+            values.push_back(cache.GetOrCreate(i, build));
+        }
+        auto kept = values[42];
+        values.clear();
+        REQUIRE(cache.Size() == 100);
+
+        for (int i = 0; i < 100; ++i) {
+            cache.Find(-1);
+        }
+        REQUIRE(cache.Size() == 1);
+        REQUIRE(cache.Find(42).Get() == kept.Get());
+    }
+
+    SECTION("Moves with its entries") {
+        std::vector<SharedPtr<std::string>> kept;
+        auto make_cache = [&build, &kept] {
+            WeakValueCache<int, std::string> cache;
+            kept.push_back(cache.GetOrCreate(1, build));
+            cache.GetOrCreate(2, build);
+            return cache;
+        };
+        std::vector<WeakValueCache<int, std::string>> caches;
+        caches.push_back(make_cache());
+        caches.push_back(make_cache());
+        caches.push_back(std::move(caches.front()));
+
+        auto& cache = caches.back();
+        cache.Sweep(10);
+        REQUIRE(cache.Size() == 1);
+        REQUIRE(cache.Find(1).Get() == kept.front().Get());
+        REQUIRE(!cache.Find(2));
+
+        caches.front() = std::move(cache);
+        REQUIRE(caches.front().Size() == 1);
+        caches.front().Sweep(10);
+        cache.Sweep(10);
+        REQUIRE(cache.Size() == 0);
+    }
+
+    SECTION("Sweep survives rehashing") {
+        WeakValueCache<int, std::string> cache;
+        std::vector<SharedPtr<std::string>> values;
+        for (int i = 0; i < 1000; ++i) {
+            values.push_back(cache.GetOrCreate(i, build));
+            if (i % 3 == 0) {
+                values.pop_back();
+            }
+        }
+        cache.Sweep(2000);
+
+        REQUIRE(cache.Size() == values.size());
+    }
+}
@@ -0,0 +1,225 @@
+#include "shared.h"
+#include "weak.h"
+#include "owner.h"
+#include "weak_key_hash_map.h"
+
+#include <catch.hpp>
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Base {
+    virtual ~Base() = default;
+    int base = 0;
+};
+
+struct Derived : Base {
+    int derived = 1;
+};
+
+TEST_CASE("Owner-based comparison") {
+    SECTION("Aliasing pointers share an owner") {
+        auto pair = MakeShared<std::pair<int, int>>(1, 2);
+        SharedPtr<int> first(pair, &pair->first);
+        SharedPtr<int> second(pair, &pair->second);
+
+        REQUIRE_FALSE(first == second);
+        REQUIRE(first.OwnerEquals(second));
+        REQUIRE(first.OwnerEquals(pair));
+        REQUIRE_FALSE(first.OwnerBefore(second));
+        REQUIRE_FALSE(second.OwnerBefore(first));
+        REQUIRE(first.OwnerHash() == second.OwnerHash());
+    }
+
+    SECTION("Different owners are ordered") {
+        auto a = MakeShared<int>(1);
+        auto b = MakeShared<int>(1);
+
+        REQUIRE_FALSE(a.OwnerEquals(b));
+        REQUIRE(a.OwnerBefore(b) != b.OwnerBefore(a));
+        REQUIRE((a < b) != (b < a));
+    }
+
+    SECTION("Converted pointers share an owner") {
+        auto derived = MakeShared<Derived>();
+        SharedPtr<Base> base = derived;
+        WeakPtr<Base> weak = derived;
+
+        REQUIRE(base.OwnerEquals(derived));
+        REQUIRE(weak.OwnerEquals(derived));
+        REQUIRE(derived.OwnerEquals(weak));
+        REQUIRE(weak.OwnerHash() == derived.OwnerHash());
+    }
+
+    SECTION("Weak pointers keep their place after expiry") {
+        WeakPtr<int> weak;
+        size_t hash;
+        {
+            auto shared = MakeShared<int>(42);
+            weak = shared;
+            hash = shared.OwnerHash();
+        }
+        WeakPtr<int> copy = weak;
+
+        REQUIRE(weak.Expired());
+        REQUIRE(weak.OwnerHash() == hash);
+        REQUIRE(weak.OwnerEquals(copy));
+        REQUIRE_FALSE(weak.OwnerBefore(copy));
+    }
+
+    SECTION("Sole owner of an adopted pointer") {
+        SharedPtr<int> shared(new int(1));
+        WeakPtr<int> weak = shared;
+
+        REQUIRE(shared.OwnerEquals(weak));
+        REQUIRE(weak.OwnerEquals(shared));
+    }
+
+    SECTION("Empty pointers are equivalent") {
+        SharedPtr<int> shared;
+        WeakPtr<int> weak;
+
+        REQUIRE(shared.OwnerEquals(weak));
+        REQUIRE_FALSE(shared.OwnerBefore(weak));
+        REQUIRE_FALSE(weak.OwnerBefore(shared));
+    }
+}
+
+TEST_CASE("Owner functors") {
+    SECTION("OwnerLess") {
+        auto a = MakeShared<int>(1);
+        auto b = MakeShared<int>(2);
+        std::set<WeakPtr<int>, OwnerLess> set{a, b, a};
+
+        REQUIRE(set.size() == 2);
+        REQUIRE(set.count(a) == 1);
+
+        std::map<WeakPtr<int>, std::string, OwnerLess> names;
+        names[a] = "a";
+        names[b] = "b";
+        a.Reset();
+
+        REQUIRE(names.size() == 2);
+        REQUIRE(names.find(b)->second == "b");
+    }
+
+    SECTION("OwnerHash and OwnerEqual") {
+        auto a = MakeShared<int>(1);
+        SharedPtr<int> alias(a, a.Get());
+        std::unordered_set<SharedPtr<int>, OwnerHash, OwnerEqual> set{a, alias};
+
+        REQUIRE(set.size() == 1);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("WeakKeyHashMap") {
+    SECTION("Insert and find") {
+        WeakKeyHashMap<int, std::string> map;
+        auto a = MakeShared<int>(1);
+        auto b = MakeShared<int>(1);
+
+        REQUIRE(map.Find(a) == nullptr);
+        map[a] = "a";
+        map.InsertOrAssign(b, "b");
+
+        REQUIRE(map.Size() == 2);
+        REQUIRE(*map.Find(a) == "a");
+        REQUIRE(*map.Find(b) == "b");
+
+        map.InsertOrAssign(a, "c");
+        REQUIRE(map.Size() == 2);
+        REQUIRE(*map.Find(a) == "c");
+    }
+
+    SECTION("Keys are compared by owner") {
+        WeakKeyHashMap<int, int> map;
+        auto pair = MakeShared<std::pair<int, int>>(1, 2);
+        SharedPtr<int> first(pair, &pair->first);
+        SharedPtr<int> second(pair, &pair->second);
+
+        map[first] = 5;
+
+        REQUIRE(map.Contains(second));
+        REQUIRE(*map.Find(second) == 5);
+    }
+
+    SECTION("Does not keep keys alive") {
+        WeakKeyHashMap<int, int> map;
+        auto a = MakeShared<int>(1);
+        map[a] = 1;
+
+        REQUIRE(a.UseCount() == 1);
+    }
+
+    SECTION("Erase") {
+        WeakKeyHashMap<int, int> map;
+        auto a = MakeShared<int>(1);
+        auto b = MakeShared<int>(2);
+        map[a] = 1;
+        map[b] = 2;
+
+        REQUIRE(map.Erase(a));
+        REQUIRE_FALSE(map.Erase(a));
+        REQUIRE(map.Size() == 1);
+        REQUIRE(map.Find(a) == nullptr);
+        REQUIRE(*map.Find(b) == 2);
+    }
+
+    SECTION("Expired keys are dropped incrementally") {
+        WeakKeyHashMap<int, SharedPtr<int>> map;
+        std::vector<SharedPtr<int>> keys;
+        auto value = MakeShared<int>(0);
+        for (int i = 0; i < 20; ++i) {
+            keys.push_back(MakeShared<int>(i));
+            map[keys.back()] = value;
+        }
+        REQUIRE(value.UseCount() == 21);
+
+        keys.clear();
+        REQUIRE(map.Size() == 20);
+
+        auto probe = MakeShared<int>(0);
+        for (size_t i = 0; i < map.Capacity(); ++i) {
+            map.Find(probe);
+        }
+        REQUIRE(map.Size() == 0);
+        REQUIRE(value.UseCount() == 1);
+    }
+
+    SECTION("Rehash keeps live keys and drops expired ones") {
+        WeakKeyHashMap<int, int> map;
+        std::vector<SharedPtr<int>> live;
+        for (int i = 0; i < 100; ++i) {
+            auto key = MakeShared<int>(i);
+            map[key] = i;
+            if (i % 2 == 0) {
+                live.push_back(key);
+            }
+        }
+        for (int i = 0; i < 100; ++i) {
+            map[MakeShared<int>(i)] = i;
+        }
+
+        REQUIRE(map.Size() <= live.size() + map.Capacity() / 2);
+        for (const auto& key : live) {
+            REQUIRE(*map.Find(key) == *key);
+        }
+    }
+
+    SECTION("Clear") {
+        WeakKeyHashMap<int, int> map;
+        auto a = MakeShared<int>(1);
+        map[a] = 1;
+        map.Clear();
+
+        REQUIRE(map.Size() == 0);
+        REQUIRE(map.Find(a) == nullptr);
+    }
+}
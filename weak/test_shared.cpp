@@ -4,7 +4,9 @@
 
 #include "allocations_checker.h"
 
+#include <iterator>
 #include <memory>
+#include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -467,3 +469,248 @@ TEST_CASE("Destructor for correct type") {
         REQUIRE(B::destructor_called);
     }
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct CountingDelete {
+    void operator()(int* ptr) {
+        if (ptr != nullptr) {
+            delete ptr;
+            ++*calls;
+        }
+    }
+
+    int* calls = nullptr;
+};
+
+TEST_CASE("From UniquePtr") {
+    SECTION("Default deleter") {
+        UniquePtr<int> up(new int(42));
+        int* p = up.Get();
+        SharedPtr<int> sp(std::move(up));
+
+        REQUIRE(!up);
+        REQUIRE(sp.Get() == p);
+        REQUIRE(sp.UseCount() == 1);
+    }
+
+    SECTION("Deleter is kept") {
+        int calls = 0;
+        {
+            UniquePtr<int, CountingDelete> up(new int(1), CountingDelete{&calls});
+            SharedPtr<int> sp(std::move(up));
+            SharedPtr<int> sp2 = sp;
+        }
+        REQUIRE(calls == 1);
+    }
+
+    SECTION("Empty") {
+        UniquePtr<int> up;
+        SharedPtr<int> sp(std::move(up));
+
+        REQUIRE(!sp);
+        REQUIRE(sp.UseCount() == 0);
+    }
+
+    SECTION("Destructor for correct type") {
+        B::destructor_called = false;
+        {
+            UniquePtr<B> up(new B);
+            SharedPtr<A> sp(std::move(up));
+        }
+        REQUIRE(B::destructor_called);
+    }
+}
+
+TEST_CASE("MakeUniqueShareable") {
+    SECTION("One allocation") {
+        EXPECT_ONE_ALLOCATION(REQUIRE(*MakeUniqueShareable<int>(42) == 42));
+    }
+
+    SECTION("Promotion does not allocate") {
+        auto up = MakeUniqueShareable<int>(7);
+        int* p = up.Get();
+        SharedPtr<int> sp;
+        EXPECT_ZERO_ALLOCATIONS(sp = SharedPtr<int>(std::move(up)));
+
+        REQUIRE(!up);
+        REQUIRE(sp.Get() == p);
+        REQUIRE(sp.UseCount() == 1);
+        SharedPtr<int> sp2 = sp;
+        REQUIRE(sp.UseCount() == 2);
+    }
+
+    SECTION("Never shared") {
+        B::destructor_called = false;
+        { auto up = MakeUniqueShareable<B>(); }
+        REQUIRE(B::destructor_called);
+    }
+
+    SECTION("Upcast on promotion") {
+        B::destructor_called = false;
+        { SharedPtr<A> sp(MakeUniqueShareable<B>()); }
+        REQUIRE(B::destructor_called);
+    }
+}
+
+TEST_CASE("ShareN") {
+    SECTION("Fan-out") {
+        auto sp = MakeShared<int>(1);
+        std::vector<SharedPtr<int>> subscribers;
+        subscribers.reserve(3);
+        EXPECT_ZERO_ALLOCATIONS(sp.ShareN(3, std::back_inserter(subscribers)));
+
+        REQUIRE(sp.UseCount() == 4);
+        REQUIRE(subscribers[2].Get() == sp.Get());
+        subscribers.pop_back();
+        sp.Reset();
+        REQUIRE(subscribers[1].UseCount() == 2);
+    }
+
+    SECTION("Into existing slots") {
+        SharedPtr<int> sp(new int(7));
+        std::vector<SharedPtr<int>> slots(4, MakeShared<int>(0));
+        auto end = sp.ShareN(slots.size(), slots.begin());
+
+        REQUIRE(end == slots.end());
+        REQUIRE(sp.UseCount() == 5);
+        REQUIRE(*slots[3] == 7);
+    }
+
+    SECTION("Empty") {
+        SharedPtr<int> sp;
+        std::vector<SharedPtr<int>> out;
+        sp.ShareN(2, std::back_inserter(out));
+
+        REQUIRE(out.size() == 2);
+        REQUIRE(!out[0]);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Message {
+    enum Kind { kPing, kData };
+
+    explicit Message(Kind kind) : kind(kind) {
+    }
+    virtual ~Message() = default;
+
+    Kind kind;
+};
+
+struct Ping : Message {
+    Ping() : Message(kPing) {
+    }
+
+    static bool ClassOf(const Message* message) {
+        return message->kind == kPing;
+    }
+};
+
+struct DataMessage : Message {
+    DataMessage() : Message(kData) {
+    }
+
+    static bool ClassOf(const Message* message) {
+        return message->kind == kData;
+    }
+
+    int payload = 7;
+};
+
+TEST_CASE("Pointer casts") {
+    SECTION("Static") {
+        SharedPtr<Message> message = MakeShared<DataMessage>();
+        auto data = StaticPointerCast<DataMessage>(message);
+
+        REQUIRE(data->payload == 7);
+        REQUIRE(message.UseCount() == 2);
+
+        SharedPtr<DataMessage> moved;
+        EXPECT_ZERO_ALLOCATIONS(moved = StaticPointerCast<DataMessage>(std::move(message)));
+        REQUIRE(!message);
+        REQUIRE(moved.Get() == data.Get());
+        REQUIRE(moved.UseCount() == 2);
+    }
+
+    SECTION("Dynamic") {
+        SharedPtr<Message> message = MakeShared<DataMessage>();
+
+        REQUIRE(!DynamicPointerCast<Ping>(message));
+        REQUIRE(!DynamicPointerCast<Ping>(std::move(message)));
+        REQUIRE(message);
+        REQUIRE(message.UseCount() == 1);
+
+        auto data = DynamicPointerCast<DataMessage>(std::move(message));
+        REQUIRE(!message);
+        REQUIRE(data->payload == 7);
+        REQUIRE(data.UseCount() == 1);
+    }
+
+    SECTION("Const") {
+        SharedPtr<const int> value = MakeShared<int>(1);
+        auto copy = ConstPointerCast<int>(value);
+        *copy = 2;
+
+        REQUIRE(*value == 2);
+        auto moved = ConstPointerCast<int>(std::move(value));
+        REQUIRE(!value);
+        REQUIRE(moved.UseCount() == 2);
+    }
+
+    SECTION("Fast dynamic") {
+        SharedPtr<Message> message = MakeShared<Ping>();
+
+        REQUIRE(!FastDynamicPointerCast<DataMessage>(message));
+        REQUIRE(FastDynamicPointerCast<Ping>(message).UseCount() == 2);
+
+        auto ping = FastDynamicPointerCast<Ping>(std::move(message));
+        REQUIRE(!message);
+        REQUIRE(ping.UseCount() == 1);
+    }
+
+    SECTION("Aliasing move") {
+        auto data = MakeShared<DataMessage>();
+        DataMessage* raw = data.Get();
+        SharedPtr<int> payload(std::move(data), &raw->payload);
+
+        REQUIRE(!data);
+        REQUIRE(*payload == 7);
+        REQUIRE(payload.UseCount() == 1);
+    }
+
+    SECTION("Sole owner stays without a control block") {
+        SharedPtr<Message> message(new DataMessage);
+        SharedPtr<DataMessage> data;
+
+        EXPECT_ZERO_ALLOCATIONS(data = StaticPointerCast<DataMessage>(std::move(message)));
+        REQUIRE(data.UseCount() == 1);
+    }
+}
+
+TEST_CASE("Immortal objects") {
+    static const SharedPtr<int> kZero = MakeImmortalShared<int>(0);
+
+    SECTION("Copies are not counted") {
+        REQUIRE(kZero.UseCount() == 2);
+        {
+            SharedPtr<int> a = kZero;
+            SharedPtr<const int> b(kZero);
+            REQUIRE(kZero.UseCount() == 2);
+        }
+        REQUIRE(kZero.UseCount() == 2);
+    }
+
+    SECTION("The last pointer does not destroy the object") {
+        {
+            SharedPtr<int> copy = kZero;
+            copy.Reset();
+        }
+        REQUIRE(*kZero == 0);
+    }
+
+    SECTION("No allocations on copies") {
+        EXPECT_ZERO_ALLOCATIONS(SharedPtr<int>{kZero});
+    }
+}
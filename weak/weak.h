@@ -2,12 +2,18 @@
 
 #include "sw_fwd.h"  // Forward declaration
 
+#include <common/trivially_relocatable.h>
+
+#include <functional>  // std::less, std::hash
+
 // https://en.cppreference.com/w/cpp/memory/weak_ptr
 template <typename T>
 class WeakPtr {
 public:
     template <typename Y>
     friend class SharedPtr;
+    template <typename Y>
+    friend class WeakPtr;
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Constructors
 
@@ -38,8 +44,10 @@ public:
     template <typename Y>
     WeakPtr(const SharedPtr<Y>& other) noexcept {
         object_ptr_ = other.object_ptr_;
-        block_ = other.block_;
-        block_->IncrementWeak();
+        block_ = other.Materialize();
+        if (block_ != nullptr) {
+            block_->IncrementWeak();
+        }
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -121,13 +129,47 @@ public:
         return true;
     };
     SharedPtr<T> Lock() const noexcept {
-        if (this->Expired()) {
-            return SharedPtr<T>();
+        return TryLock();
+    };
+    // Empty if the object is gone. Checks and increments the counter in one step
+    // and never throws, unlike `SharedPtr(const WeakPtr&)`.
+    SharedPtr<T> TryLock() const noexcept {
+        SharedPtr<T> result;
+        if (block_ != nullptr && block_->TryIncrementStrong()) {
+            result.object_ptr_ = object_ptr_;
+            result.block_ = block_;
         }
-        return SharedPtr(*this);
+        return result;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Owner-based ordering and hashing
+    // Stay valid after expiry: the control block lives as long as any `WeakPtr` to it.
+
+    template <typename Y>
+    bool OwnerBefore(const WeakPtr<Y>& other) const noexcept {
+        return std::less<const ControlBlock*>()(block_, other.block_);
+    };
+    template <typename Y>
+    bool OwnerBefore(const SharedPtr<Y>& other) const {
+        return std::less<const ControlBlock*>()(block_, other.Materialize());
+    };
+    template <typename Y>
+    bool OwnerEquals(const WeakPtr<Y>& other) const noexcept {
+        return block_ == other.block_;
+    };
+    template <typename Y>
+    bool OwnerEquals(const SharedPtr<Y>& other) const {
+        return block_ == other.Materialize();
+    };
+    size_t OwnerHash() const noexcept {
+        return std::hash<const ControlBlock*>()(block_);
     };
 
 private:
     T* object_ptr_;
     ControlBlock* block_;
 };
+
+template <typename T>
+struct IsTriviallyRelocatable<WeakPtr<T>> : std::true_type {};
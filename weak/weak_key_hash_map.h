@@ -0,0 +1,219 @@
+#pragma once
+
+#include "shared.h"
+#include "weak.h"
+
+#include <bit>
+#include <cassert>
+#include <cstddef>  // size_t
+#include <cstdint>  // uint64_t
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Open-addressing hash map keyed by object identity that does not keep its keys alive.
+// Keys are held as `WeakPtr` and hashed by owner, so a key keeps its slot after it expires
+// and no other object can take its identity while the slot exists.
+// Expired keys are dropped incrementally: on every probe that passes them and by a sweep
+// cursor that advances a few slots per operation. No operation walks the whole table,
+// except rehashing, which is amortized over insertions.
+template <typename K, typename V>
+class WeakKeyHashMap {
+public:
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    WeakKeyHashMap() = default;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Lookup
+
+    // Value of a live key, or `nullptr`.
+    V* Find(const SharedPtr<K>& key) {
+        Sweep(kSweepSteps);
+        if (!key || slots_.empty()) {
+            return nullptr;
+        }
+        Slot* slot = Lookup(key, key.OwnerHash()).found;
+        return slot != nullptr ? &*slot->value : nullptr;
+    }
+
+    bool Contains(const SharedPtr<K>& key) {
+        return Find(key) != nullptr;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Modifiers
+
+    template <typename... Args>
+    V& InsertOrAssign(const SharedPtr<K>& key, Args&&... args) {
+        V& value = (*this)[key];
+        value = V(std::forward<Args>(args)...);
+        return value;
+    }
+
+    // Value of `key`, default-constructed if there was none.
+    V& operator[](const SharedPtr<K>& key) {
+        assert(key);
+        Sweep(kSweepSteps);
+        if ((size_ + tombstones_ + 1) * 2 > slots_.size()) {
+            Rehash();
+        }
+        size_t hash = key.OwnerHash();
+        Probe probe = Lookup(key, hash);
+        if (probe.found != nullptr) {
+            return *probe.found->value;
+        }
+        Slot& slot = *probe.free;
+        if (slot.state == State::kDeleted) {
+            --tombstones_;
+        }
+        slot.key = WeakPtr<K>(key);
+        slot.value.emplace();
+        slot.hash = hash;
+        slot.state = State::kFull;
+        ++size_;
+        return *slot.value;
+    }
+
+    bool Erase(const SharedPtr<K>& key) {
+        Sweep(kSweepSteps);
+        if (!key || slots_.empty()) {
+            return false;
+        }
+        Slot* slot = Lookup(key, key.OwnerHash()).found;
+        if (slot == nullptr) {
+            return false;
+        }
+        Remove(*slot);
+        return true;
+    }
+
+    // Examines up to `steps` slots after the sweep cursor and drops expired keys.
+    void Sweep(size_t steps) {
+        for (size_t i = 0; i < steps && i < slots_.size(); ++i) {
+            cursor_ = (cursor_ + 1) & (slots_.size() - 1);
+            Slot& slot = slots_[cursor_];
+            if (slot.state == State::kFull && slot.key.Expired()) {
+                Remove(slot);
+            }
+        }
+    }
+
+    void Clear() {
+        slots_.clear();
+        size_ = 0;
+        tombstones_ = 0;
+        cursor_ = 0;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    // Number of stored entries. Expired keys are counted until they are swept.
+    size_t Size() const noexcept {
+        return size_;
+    }
+    size_t Capacity() const noexcept {
+        return slots_.size();
+    }
+
+private:
+    static constexpr size_t kSweepSteps = 2;
+    static constexpr size_t kMinCapacity = 8;
+
+    enum class State { kEmpty, kFull, kDeleted };
+
+    struct Slot {
+        WeakPtr<K> key;
+        std::optional<V> value;
+        size_t hash = 0;
+        State state = State::kEmpty;
+    };
+
+    struct Probe {
+        Slot* found = nullptr;
+        Slot* free = nullptr;
+    };
+
+    // Fibonacci hashing: control block addresses have zero low bits, take the high bits instead
+    size_t IndexOf(size_t hash) const noexcept {
+        return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >>
+                                   shift_);
+    }
+
+    Probe Lookup(const SharedPtr<K>& key, size_t hash) {
+        Probe probe;
+        size_t mask = slots_.size() - 1;
+        size_t index = IndexOf(hash);
+        for (size_t step = 0; step < slots_.size(); ++step, index = (index + 1) & mask) {
+            Slot& slot = slots_[index];
+            if (slot.state == State::kFull && slot.key.Expired()) {
+                Remove(slot);
+            }
+            if (slot.state == State::kEmpty) {
+                if (probe.free == nullptr) {
+                    probe.free = &slot;
+                }
+                return probe;
+            }
+            if (slot.state == State::kDeleted) {
+                if (probe.free == nullptr) {
+                    probe.free = &slot;
+                }
+                continue;
+            }
+            if (slot.hash == hash && slot.key.OwnerEquals(key)) {
+                probe.found = &slot;
+                return probe;
+            }
+        }
+        return probe;
+    }
+
+    void Remove(Slot& slot) {
+        slot.key.Reset();
+        slot.value.reset();
+        slot.state = State::kDeleted;
+        --size_;
+        ++tombstones_;
+    }
+
+    // Rebuilds the table without tombstones and expired keys.
+    void Rehash() {
+        std::vector<Slot> old = std::move(slots_);
+        size_t live = 0;
+        for (const Slot& slot : old) {
+            if (slot.state == State::kFull && !slot.key.Expired()) {
+                ++live;
+            }
+        }
+        size_t capacity = kMinCapacity;
+        while (capacity < 4 * (live + 1)) {
+            capacity *= 2;
+        }
+        slots_ = std::vector<Slot>(capacity);
+        shift_ = 64 - std::countr_zero(capacity);
+        size_ = 0;
+        tombstones_ = 0;
+        cursor_ = 0;
+        for (Slot& slot : old) {
+            if (slot.state != State::kFull || slot.key.Expired()) {
+                continue;
+            }
+            size_t mask = capacity - 1;
+            size_t i = IndexOf(slot.hash);
+            while (slots_[i].state != State::kEmpty) {
+                i = (i + 1) & mask;
+            }
+            slots_[i] = std::move(slot);
+            ++size_;
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+    size_t tombstones_ = 0;
+    size_t cursor_ = 0;
+    int shift_ = 64;
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "shared.h"
+#include "weak.h"
+
+#include <cstddef>  // size_t
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+// Cache of shared values that does not keep them alive: entries hold `WeakPtr`-s and a value
+// is rebuilt when it is requested after its last owner is gone.
+// Entries of expired values are removed incrementally, by the lookup that finds them and by
+// a sweep cursor that advances a few entries per operation, so no call walks the whole map.
+template <typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+class WeakValueCache {
+public:
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    WeakValueCache() = default;
+
+    // The sweep cursor points into `entries_`
+    WeakValueCache(const WeakValueCache&) = delete;
+    WeakValueCache& operator=(const WeakValueCache&) = delete;
+
+    // The cursor of `other` may be its end iterator, which does not move with the entries:
+    // sweeping starts over, and `other` is left with a valid cursor
+    WeakValueCache(WeakValueCache&& other) noexcept(std::is_nothrow_move_constructible_v<Map>)
+        : entries_(std::move(other.entries_)) {
+        other.cursor_ = other.entries_.end();
+    }
+    WeakValueCache& operator=(WeakValueCache&& other) noexcept(
+        std::is_nothrow_move_assignable_v<Map>) {
+        if (this == &other) {
+            return *this;
+        }
+        entries_ = std::move(other.entries_);
+        cursor_ = entries_.end();
+        other.cursor_ = other.entries_.end();
+        return *this;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Lookup
+
+    // Live value of `key`, or an empty pointer.
+    SharedPtr<V> Find(const K& key) {
+        Sweep(kSweepSteps);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            return SharedPtr<V>();
+        }
+        SharedPtr<V> value = it->second.Lock();
+        if (!value) {
+            EraseEntry(it);
+        }
+        return value;
+    }
+
+    // Live value of `key`, or the result of `factory(key)`, which is cached.
+    // Nothing is stored if `factory` throws or returns an empty pointer.
+    template <typename Factory>
+    SharedPtr<V> GetOrCreate(const K& key, Factory&& factory) {
+        SharedPtr<V> value = Find(key);
+        if (value) {
+            return value;
+        }
+        value = std::forward<Factory>(factory)(key);
+        if (value) {
+            Insert(key, value);
+        }
+        return value;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Modifiers
+
+    void Insert(const K& key, const SharedPtr<V>& value) {
+        Sweep(kSweepSteps);
+        size_t buckets = entries_.bucket_count();
+        entries_.insert_or_assign(key, WeakPtr<V>(value));
+        if (entries_.bucket_count() != buckets) {
+            // Rehashing invalidated the cursor
+            cursor_ = entries_.begin();
+        }
+    }
+
+    bool Erase(const K& key) {
+        Sweep(kSweepSteps);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            return false;
+        }
+        EraseEntry(it);
+        return true;
+    }
+
+    // Examines up to `steps` entries after the sweep cursor and removes expired ones.
+    void Sweep(size_t steps) {
+        for (size_t i = 0; i < steps && !entries_.empty(); ++i) {
+            if (cursor_ == entries_.end()) {
+                cursor_ = entries_.begin();
+            }
+            if (cursor_->second.Expired()) {
+                cursor_ = entries_.erase(cursor_);
+            } else {
+                ++cursor_;
+            }
+        }
+    }
+
+    void Clear() {
+        entries_.clear();
+        cursor_ = entries_.end();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    // Number of entries. Expired values are counted until they are swept.
+    size_t Size() const noexcept {
+        return entries_.size();
+    }
+
+private:
+    using Map = std::unordered_map<K, WeakPtr<V>, Hash, Equal>;
+
+    static constexpr size_t kSweepSteps = 2;
+
+    void EraseEntry(typename Map::iterator it) {
+        if (it == cursor_) {
+            cursor_ = entries_.erase(it);
+        } else {
+            entries_.erase(it);
+        }
+    }
+
+    Map entries_;
+    typename Map::iterator cursor_ = entries_.end();
+};